@@ -1,5 +1,7 @@
 #include "CS250Parser.h"
 
+#include <algorithm>
+
 float   CS250Parser::left;
 float   CS250Parser::right;
 float   CS250Parser::top;
@@ -17,6 +19,7 @@ std::vector<Point4>            CS250Parser::colors;
 std::vector<Point4>            CS250Parser::textureCoords;
 
 std::vector<CS250Parser::Transform> CS250Parser::objects;
+std::vector<int>                    CS250Parser::levelStart;
 
 void CS250Parser::LoadDataFromFile(const char * filename)
 {
@@ -117,6 +120,7 @@ void CS250Parser::LoadDataFromFile(const char * filename)
                  parent, 512);
         transform.name = name;
         transform.parent = parent;
+        transform.orientation = Quaternion::FromEuler(transform.rot);
         
         objects.push_back(transform);
     }
@@ -124,4 +128,84 @@ void CS250Parser::LoadDataFromFile(const char * filename)
     //
 
     fclose(in);
+
+    SortObjects();
+}
+
+// Resolve the parent names to indices and sort the objects so parents come first
+void CS250Parser::SortObjects()
+{
+    unsigned count = static_cast<unsigned>(objects.size());
+
+    // Parent of each object by name, unknown parents are treated as roots
+    for (unsigned i = 0; i < count; i++)
+    {
+        objects[i].parentIndex = -1;
+        for (unsigned j = 0; j < count; j++)
+        {
+            if (i != j && objects[i].parent == objects[j].name)
+            {
+                objects[i].parentIndex = j;
+                break;
+            }
+        }
+    }
+
+    // Cut every cycle at its first object in file order. Only the objects on a cycle get
+    // back to themselves; the ones that just lead into a cycle keep their parent
+    for (unsigned i = 0; i < count; i++)
+    {
+        int parent = objects[i].parentIndex;
+        for (unsigned steps = 0; parent >= 0 && parent != static_cast<int>(i) && steps < count; steps++)
+            parent = objects[parent].parentIndex;
+
+        if (parent == static_cast<int>(i))
+            objects[i].parentIndex = -1;
+    }
+
+    // Level of each object, every chain ends at a root now
+    for (unsigned i = 0; i < count; i++)
+    {
+        int level  = 0;
+        int parent = objects[i].parentIndex;
+        while (parent >= 0)
+        {
+            level++;
+            parent = objects[parent].parentIndex;
+        }
+
+        objects[i].level = level;
+    }
+
+    // Parents before children, keeping the file order inside each level
+    std::vector<int> newIndex(count);
+    std::vector<int> oldIndex(count);
+    for (unsigned i = 0; i < count; i++)
+        oldIndex[i] = i;
+
+    std::stable_sort(oldIndex.begin(), oldIndex.end(), [](int a, int b)
+    {
+        return objects[a].level < objects[b].level;
+    });
+
+    std::vector<Transform> sorted;
+    sorted.reserve(count);
+    for (unsigned i = 0; i < count; i++)
+    {
+        newIndex[oldIndex[i]] = i;
+        sorted.push_back(objects[oldIndex[i]]);
+    }
+
+    levelStart.clear();
+    for (unsigned i = 0; i < count; i++)
+    {
+        if (sorted[i].parentIndex >= 0)
+            sorted[i].parentIndex = newIndex[sorted[i].parentIndex];
+
+        if (levelStart.size() <= static_cast<unsigned>(sorted[i].level))
+            levelStart.push_back(i);
+    }
+    levelStart.push_back(count);
+
+    objects.swap(sorted);
 }
\ No newline at end of file
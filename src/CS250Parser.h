@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Math/Point4.h"
+#include "Math/Matrix4.h"
+#include "Math/Affine4.h"
+#include "Math/Quaternion.h"
 #include <string>
 #include <vector>
 
@@ -34,11 +37,26 @@ class CS250Parser
     {
         std::string name;
 
-        Point4  pos;
-        Vector4 rot;
-        Vector4 sca;
+        Point4     pos;
+        Vector4    rot;             // Euler angles from the file
+        Vector4    sca;
+        Quaternion orientation;     // built from rot, what the input modifies
 
         std::string parent;
+        int         parentIndex = -1;   // index of the parent in objects, -1 for roots
+        int         level       = 0;    // depth in the hierarchy, 0 for roots
+
+        // Cached matrices, rebuilt only when dirty (all affine)
+        Affine4 local;          // T * R
+        Affine4 world;          // parent world * local, what the children are relative to
+        Affine4 m2w;            // world * S, used to draw the object
+        bool    dirty = true;   // pos/orientation changed here or in a parent
     };
+    // Sorted by level, so parents always come before their children
     static std::vector<Transform> objects;
+    // First object of each level, plus objects.size() at the end
+    static std::vector<int>       levelStart;
+
+  private:
+    static void SortObjects();
 };
\ No newline at end of file
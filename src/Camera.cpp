@@ -0,0 +1,113 @@
+#include "Camera.h"
+
+
+/**
+* @brief SetLookAt:     place the camera, the matrices are rebuilt only if it moved
+*
+* @param eye:           position of the camera
+* @param viewDir:       direction the camera looks at
+* @param upDir:         up direction, does not need to be perpendicular to viewDir
+*/
+void Camera::SetLookAt(const Point4 & eye, const Vector4 & viewDir, const Vector4 & upDir)
+{
+    if (eye == position && viewDir == view && upDir == up)
+        return;
+
+    position = eye;
+    view     = viewDir;
+    up       = upDir;
+    dirty    = true;
+}
+
+/**
+* @brief SetPerspective: set the projection, the matrices are rebuilt only if it changed
+*
+* @param focalLength:   distance from the camera to the projection plane
+* @param nearDist:      distance to the near plane, depth 0
+* @param farDist:       distance to the far plane, depth 1
+*/
+void Camera::SetPerspective(float focalLength, float nearDist, float farDist)
+{
+    if (focalLength == focal && nearDist == nearPlane && farDist == farPlane)
+        return;
+
+    focal     = focalLength;
+    nearPlane = nearDist;
+    farPlane  = farDist;
+    dirty     = true;
+}
+
+/**
+* @brief GetView:       world to camera matrix
+*
+* @return               the cached matrix, rebuilt first if needed
+*/
+const Affine4 & Camera::GetView()
+{
+    if (dirty)
+        Rebuild();
+
+    return viewMatrix;
+}
+
+/**
+* @brief GetProjection: camera to clip space matrix
+*
+* @return               the cached matrix, rebuilt first if needed
+*/
+const Matrix4 & Camera::GetProjection()
+{
+    if (dirty)
+        Rebuild();
+
+    return projection;
+}
+
+/**
+* @brief GetViewProjection: world to clip space matrix
+*
+* @return                   the cached matrix, rebuilt first if needed
+*/
+const Matrix4 & Camera::GetViewProjection()
+{
+    if (dirty)
+        Rebuild();
+
+    return viewProjection;
+}
+
+/**
+* @brief Rebuild:       build the view and projection matrices from the parameters
+*
+* @param (void)
+*/
+void Camera::Rebuild()
+{
+    //Camera basis: w looks backwards, u to the right and v up
+    Vector4 w = -view;
+    w.Normalize();
+
+    Vector4 u = up.Cross(w);
+    if (u.LengthSq() == 0.f)
+        u = Vector4(0.f, 0.f, 1.f).Cross(w);   //Up parallel to the view, any perpendicular works
+    u.Normalize();
+
+    Vector4 v = w.Cross(u);
+
+    //The basis is orthonormal, so the inverse rotation is the transpose
+    Vector4 eye(position.x, position.y, position.z);
+    viewMatrix = Affine4(u.x, u.y, u.z, -u.Dot(eye),
+                         v.x, v.y, v.z, -v.Dot(eye),
+                         w.x, w.y, w.z, -w.Dot(eye));
+
+    //Perspective projection, w = -z / focal so x and y end on the projection plane
+    //z goes to 0 at the near plane and 1 at the far plane after the division
+    float depthScale = -farPlane / (focal * (farPlane - nearPlane));
+    projection = Matrix4(1.f, 0.f, 0.f,            0.f,
+                         0.f, 1.f, 0.f,            0.f,
+                         0.f, 0.f, depthScale,     depthScale * nearPlane,
+                         0.f, 0.f, -1.f / focal,   0.f);
+
+    viewProjection = projection * viewMatrix;
+    dirty = false;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Math/Matrix4.h"
+#include "Math/Affine4.h"
+#include "Math/Point4.h"
+#include "Math/Vector4.h"
+
+// Look-at view and perspective projection of the scene camera.
+// The matrices are cached and only rebuilt after a parameter changes.
+// Depth after the perspective division goes from 0 at the near plane to 1 at the far
+// plane, so smaller is still closer.
+class Camera
+{
+  public:
+    void SetLookAt(const Point4 & eye, const Vector4 & viewDir, const Vector4 & upDir);
+    void SetPerspective(float focalLength, float nearDist, float farDist);
+
+    const Affine4 & GetView();              //World to camera
+    const Matrix4 & GetProjection();        //Camera to clip space
+    const Matrix4 & GetViewProjection();    //Both, world to clip space
+
+    float GetNear() const { return nearPlane; }
+    float GetFar() const  { return farPlane; }
+
+  private:
+    void Rebuild();
+
+    Point4  position;
+    Vector4 view{0.f, 0.f, -1.f};
+    Vector4 up{0.f, 1.f, 0.f};
+    float   focal     = 1.f;                //Distance to the projection plane
+    float   nearPlane = 1.f;
+    float   farPlane  = 100.f;
+
+    Affine4 viewMatrix;
+    Matrix4 projection;
+    Matrix4 viewProjection;
+    bool    dirty = true;                   //A parameter changed since the last rebuild
+};
@@ -0,0 +1,97 @@
+#include "Clipper.h"
+#include <utility>
+
+namespace Clipper
+{
+
+// Signed distance (scaled by w) of a point to a plane, positive on the inside
+float Distance(const Point4 & p, int plane, float extentX, float extentY)
+{
+    switch (plane)
+    {
+        case PLANE_NEAR:   return p.z;
+        case PLANE_FAR:    return p.w - p.z;
+        case PLANE_LEFT:   return p.x + extentX * p.w;
+        case PLANE_RIGHT:  return extentX * p.w - p.x;
+        case PLANE_BOTTOM: return p.y + extentY * p.w;
+        default:           return extentY * p.w - p.y;
+    }
+}
+
+unsigned OutCode(const Point4 & p, float extentX, float extentY)
+{
+    unsigned code = 0;
+
+    if (p.z < 0.f)
+        code |= PLANE_NEAR;
+    if (p.z > p.w)
+        code |= PLANE_FAR;
+    if (p.x < -extentX * p.w)
+        code |= PLANE_LEFT;
+    if (p.x > extentX * p.w)
+        code |= PLANE_RIGHT;
+    if (p.y < -extentY * p.w)
+        code |= PLANE_BOTTOM;
+    if (p.y > extentY * p.w)
+        code |= PLANE_TOP;
+
+    return code;
+}
+
+// Vertex at t along the edge from a to b, position and color
+Rasterizer::Vertex Lerp(const Rasterizer::Vertex & a, const Rasterizer::Vertex & b, float t)
+{
+    Rasterizer::Vertex v;
+    v.position = a.position + (b.position - a.position) * t;
+    v.color    = a.color + (b.color - a.color) * t;
+
+    return v;
+}
+
+int ClipTriangle(const Rasterizer::Vertex in[3], Rasterizer::Vertex out[MAX_VERTICES],
+                 unsigned planes, float extentX, float extentY)
+{
+    // Ping-pong between two polygons, one plane at a time
+    Rasterizer::Vertex bufferA[MAX_VERTICES], bufferB[MAX_VERTICES];
+    Rasterizer::Vertex * src = bufferA;
+    Rasterizer::Vertex * dst = bufferB;
+    int count = 3;
+
+    for (int i = 0; i < 3; i++)
+        src[i] = in[i];
+
+    for (int plane = PLANE_NEAR; plane <= PLANE_TOP && count > 0; plane <<= 1)
+    {
+        if (!(planes & plane))
+            continue;
+
+        int   kept  = 0;
+        float dPrev = Distance(src[count - 1].position, plane, extentX, extentY);
+
+        // Every edge, from the previous vertex to the current one
+        for (int i = 0, prev = count - 1; i < count; prev = i++)
+        {
+            float d = Distance(src[i].position, plane, extentX, extentY);
+
+            // The edge crosses the plane: keep the intersection
+            // (the bound only matters for almost degenerate triangles)
+            if ((d >= 0.f) != (dPrev >= 0.f) && kept < MAX_VERTICES)
+                dst[kept++] = Lerp(src[prev], src[i], dPrev / (dPrev - d));
+
+            if (d >= 0.f && kept < MAX_VERTICES)
+                dst[kept++] = src[i];
+
+            dPrev = d;
+        }
+
+        count = kept;
+        std::swap(src, dst);
+    }
+
+    for (int i = 0; i < count; i++)
+        out[i] = src[i];
+
+    return count;
+}
+
+} // namespace Clipper
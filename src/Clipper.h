@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Rasterizer.h"
+
+// Clipping of triangles in homogeneous clip space, before the perspective division.
+// Inside the frustum of the Camera projection 0 <= z <= w, and x and y are between
+// -extent * w and extent * w, where the extents are half the size of the view
+namespace Clipper
+{
+
+enum Plane
+{
+    PLANE_NEAR   = 1,
+    PLANE_FAR    = 2,
+    PLANE_LEFT   = 4,
+    PLANE_RIGHT  = 8,
+    PLANE_BOTTOM = 16,
+    PLANE_TOP    = 32
+};
+
+// Size of the guard band relative to the screen. Triangles that only cross the
+// screen edges are not clipped in x and y, the rasterizers scissor them instead
+const float GUARD_BAND = 2.f;
+
+// Every plane can add one vertex to the triangle
+const int MAX_VERTICES = 3 + 6;
+
+// Planes the point is outside of, as a mask of Plane bits
+unsigned OutCode(const Point4 & p, float extentX, float extentY);
+
+// Sutherland-Hodgman clipping of a triangle (positions in clip space) against the
+// planes in the mask. Writes the clipped convex polygon, with the colors interpolated,
+// and returns its number of vertices (0 if nothing is left)
+int ClipTriangle(const Rasterizer::Vertex in[3], Rasterizer::Vertex out[MAX_VERTICES],
+                 unsigned planes, float extentX, float extentY);
+
+} // namespace Clipper
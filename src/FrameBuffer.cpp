@@ -1,33 +1,160 @@
 #include "FrameBuffer.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <vector>
 
-int             FrameBuffer::width     = 0;
-int             FrameBuffer::height    = 0;
-unsigned char * FrameBuffer::imageData = nullptr;
+#include "Math/MathUtilities.h"     // CpuHasAVX2
 
-void FrameBuffer::Init(int w, int h)
+#if defined(_M_X64) || defined(__x86_64__)
+    #define FRAMEBUFFER_SIMD
+#endif
+
+// The span writer only depends on the CPU, it is selected once before main
+const char *            FrameBuffer::spanWriterName = "scalar";
+FrameBuffer::SpanWriter FrameBuffer::spanWriter     = FrameBuffer::SelectSpanWriter(&FrameBuffer::spanWriterName);
+
+// Both planes start on a cache line, so the rows and the SIMD stores do not straddle lines
+const size_t CACHE_LINE = 64;
+
+// Cache line aligned allocation, the pointer returned by new is kept just before the block
+static void * AllocateAligned(size_t size)
 {
-    width     = w;
-    height    = h;
-    int size  = 3 * width * height;
-    imageData = new unsigned char[size];
+    unsigned char * raw     = new unsigned char[size + CACHE_LINE + sizeof(void *)];
+    uintptr_t       aligned = (reinterpret_cast<uintptr_t>(raw) + sizeof(void *) + CACHE_LINE - 1) & ~(CACHE_LINE - 1);
+
+    reinterpret_cast<unsigned char **>(aligned)[-1] = raw;
+    return reinterpret_cast<void *>(aligned);
 }
 
-void FrameBuffer::Free()
+static void FreeAligned(void * block)
 {
-    delete[] imageData;
+    if (block)
+        delete[] static_cast<unsigned char **>(block)[-1];
 }
 
-void FrameBuffer::Clear(unsigned char r, unsigned char g, unsigned char b)
+// Fills count 32-bit values, with memset when all 4 bytes are the same
+// dst must be 16-byte aligned
+static void Fill32(void * dst, uint32_t value, size_t count)
 {
-    for (int x = 0; x < width; x++)
+    if ((value & 0xFF) * 0x01010101u == value)
     {
-        for (int y = 0; y < height; y++)
-        {
-            imageData[(y * width + x) * 3 + 0] = r;
-            imageData[(y * width + x) * 3 + 1] = g;
-            imageData[(y * width + x) * 3 + 2] = b;
-        }
+        memset(dst, value & 0xFF, 4 * count);
+        return;
     }
+
+    uint32_t * out = static_cast<uint32_t *>(dst);
+    size_t     i   = 0;
+
+#ifdef FRAMEBUFFER_SIMD
+    // The buffers are aligned, 16 values (a cache line) per iteration
+    const __m128i fill = _mm_set1_epi32(static_cast<int>(value));
+    for (; i + 16 <= count; i += 16)
+    {
+        __m128i * line = reinterpret_cast<__m128i *>(out + i);
+        _mm_store_si128(line, fill);
+        _mm_store_si128(line + 1, fill);
+        _mm_store_si128(line + 2, fill);
+        _mm_store_si128(line + 3, fill);
+    }
+#endif
+
+    for (; i < count; i++)
+        out[i] = value;
+}
+
+// Select the span writer for this CPU, SSE2 is always there on x64
+FrameBuffer::SpanWriter FrameBuffer::SelectSpanWriter(const char ** name)
+{
+#ifdef FRAMEBUFFER_SIMD
+    if (CpuHasAVX2())
+    {
+        *name = "AVX2";
+        return DrawSpanAVX2;
+    }
+
+    *name = "SSE2";
+    return DrawSpanSSE2;
+#else
+    *name = "scalar";
+    return DrawSpanScalar;
+#endif
+}
+
+FrameBuffer::FrameBuffer(int w, int h, Layout l, bool depth)
+{
+    Init(w, h, l, depth);
+}
+
+FrameBuffer::~FrameBuffer()
+{
+    Free();
+}
+
+void FrameBuffer::Init(int w, int h, Layout l, bool depth)
+{
+    Free();
+
+    layout = l;
+    width  = w;
+    height = h;
+    tilesX = (width + TILE_SIZE - 1) >> TILE_SHIFT;
+    tilesY = (height + TILE_SIZE - 1) >> TILE_SHIFT;
+
+    // The tiled planes are padded to whole tiles, and need a linear copy to present
+    pixelCount = static_cast<size_t>(width) * height;
+    if (layout == LAYOUT_TILED)
+    {
+        pixelCount  = static_cast<size_t>(tilesX) * tilesY * TILE_SIZE * TILE_SIZE;
+        resolveData = static_cast<unsigned char *>(AllocateAligned(4 * static_cast<size_t>(width) * height));
+    }
+
+    imageData = static_cast<unsigned char *>(AllocateAligned(4 * pixelCount));
+    if (depth)
+        depthData = static_cast<float *>(AllocateAligned(sizeof(float) * pixelCount));
+}
+
+void FrameBuffer::Free()
+{
+    FreeAligned(imageData);
+    FreeAligned(depthData);
+    FreeAligned(resolveData);
+    imageData   = nullptr;
+    depthData   = nullptr;
+    resolveData = nullptr;
+}
+
+// Clears the color and the depth (to the farthest value) in one call
+void FrameBuffer::Clear(unsigned char r, unsigned char g, unsigned char b)
+{
+    ClearColor(r, g, b);
+    ClearDepth(FAR_DEPTH);
+}
+
+// Both planes are contiguous in either layout, so each one is cleared as a single linear fill
+void FrameBuffer::ClearColor(unsigned char r, unsigned char g, unsigned char b)
+{
+    if (imageData == nullptr)
+        return;
+
+    // The RGBA bytes of one pixel, white is a plain memset
+    unsigned char pixel[4] = {r, g, b, 255};
+    uint32_t      value;
+    memcpy(&value, pixel, 4);
+
+    Fill32(imageData, value, pixelCount);
+}
+
+void FrameBuffer::ClearDepth(float z)
+{
+    if (depthData == nullptr)
+        return;
+
+    uint32_t value;
+    memcpy(&value, &z, 4);
+
+    Fill32(depthData, value, pixelCount);
 }
 
 void FrameBuffer::SetPixel(int x, int y, unsigned char r, unsigned char g, unsigned char b)
@@ -37,15 +164,16 @@ void FrameBuffer::SetPixel(int x, int y, unsigned char r, unsigned char g, unsig
         return;
 
     // advance to pixel
-    unsigned offset = 3 * (y * width + x);
+    size_t offset = 4 * PixelIndex(x, y);
 
-    // set
+    // set, the alpha is always opaque
     imageData[offset] = r;
     imageData[offset + 1] = g;
     imageData[offset + 2] = b;
+    imageData[offset + 3] = 255;
 }
 
-void FrameBuffer::GetPixel(int x, int y, unsigned char & r, unsigned char & g, unsigned char & b)
+void FrameBuffer::GetPixel(int x, int y, unsigned char & r, unsigned char & g, unsigned char & b) const
 {
     // Sanity check
     if (imageData == nullptr || width <= x || height <= y)
@@ -58,7 +186,7 @@ void FrameBuffer::GetPixel(int x, int y, unsigned char & r, unsigned char & g, u
     }
 
     // advance to pixel
-    unsigned startOffset = 3 * (y * width + x);
+    size_t startOffset = 4 * PixelIndex(x, y);
 
     // Get the color component
     r = imageData[startOffset];
@@ -67,19 +195,312 @@ void FrameBuffer::GetPixel(int x, int y, unsigned char & r, unsigned char & g, u
 
 }
 
-// Convert the custom framebuffer to SFML format
-void FrameBuffer::ConvertFrameBufferToSFMLImage(sf::Image & image)
+// Compare z with the stored depth, keeping it if it is closer (smaller)
+bool FrameBuffer::DepthTest(int x, int y, float z)
+{
+    // Sanity check
+    if (width <= x || x < 0 || height <= y || y < 0)
+        return false;
+
+    // Nothing to compare with, everything is visible
+    if (depthData == nullptr)
+        return true;
+
+    float & depth = depthData[PixelIndex(x, y)];
+    if (z >= depth)
+        return false;
+
+    depth = z;
+    return true;
+}
+
+float FrameBuffer::GetDepth(int x, int y) const
 {
-    int w = FrameBuffer::GetWidth();
-    int h = FrameBuffer::GetHeight();
+    // Sanity check
+    if (depthData == nullptr || width <= x || x < 0 || height <= y || y < 0)
+        return FAR_DEPTH;
 
-    for (int x = 0; x < w; x++)
+    return depthData[PixelIndex(x, y)];
+}
+
+void FrameBuffer::DrawSpan(int y, int x0, int x1, float r, float g, float b, float z, float rInc, float gInc, float bInc, float zInc)
+{
+    // Sanity check, done once for the whole span
+    if (imageData == nullptr || y < 0 || height <= y)
+        return;
+
+    if (x0 < 0)
+    {
+        r += rInc * -x0;
+        g += gInc * -x0;
+        b += bInc * -x0;
+        z += zInc * -x0;
+        x0 = 0;
+    }
+    if (width <= x1)
+        x1 = width - 1;
+
+    if (x1 < x0)
+        return;
+
+    // Without a depth plane the pixels are written as they come
+    SpanWriter writer = depthData ? spanWriter : DrawSpanNoDepth;
+
+    if (layout == LAYOUT_LINEAR)
+    {
+        size_t start = PixelIndex(x0, y);
+        writer(depthData ? depthData + start : nullptr, imageData + 4 * start, x1 - x0 + 1, r, g, b, z, rInc, gInc, bInc, zInc);
+        return;
+    }
+
+    // Tiled: the span is only contiguous inside a tile, one piece per tile it crosses
+    for (int x = x0; x <= x1;)
     {
-        for (int y = 0; y < h; y++)
+        int    end    = std::min(x1, x | (TILE_SIZE - 1));
+        size_t start  = PixelIndex(x, y);
+        float  offset = static_cast<float>(x - x0);
+
+        writer(depthData ? depthData + start : nullptr, imageData + 4 * start, end - x + 1,
+               r + rInc * offset, g + gInc * offset, b + bInc * offset, z + zInc * offset, rInc, gInc, bInc, zInc);
+        x = end + 1;
+    }
+}
+
+void FrameBuffer::DrawSpanNoDepth(float *, unsigned char * color, int count, float r, float g, float b, float, float rInc, float gInc, float bInc, float)
+{
+    for (int x = 0; x < count; x++)
+    {
+        color[4 * x]     = static_cast<unsigned char>(r * 255.99);
+        color[4 * x + 1] = static_cast<unsigned char>(g * 255.99);
+        color[4 * x + 2] = static_cast<unsigned char>(b * 255.99);
+        color[4 * x + 3] = 255;
+
+        r += rInc;
+        g += gInc;
+        b += bInc;
+    }
+}
+
+void FrameBuffer::DrawSpanScalar(float * depth, unsigned char * color, int count, float r, float g, float b, float z, float rInc, float gInc, float bInc, float zInc)
+{
+    for (int x = 0; x < count; x++)
+    {
+        if (z < depth[x])
         {
-            unsigned char r, b, g;
-            FrameBuffer::GetPixel(x, y, r, g, b);
-            image.setPixel(x, y, sf::Color(r, g, b));
+            depth[x]         = z;
+            color[4 * x]     = static_cast<unsigned char>(r * 255.99);
+            color[4 * x + 1] = static_cast<unsigned char>(g * 255.99);
+            color[4 * x + 2] = static_cast<unsigned char>(b * 255.99);
+            color[4 * x + 3] = 255;
         }
+
+        r += rInc;
+        g += gInc;
+        b += bInc;
+        z += zInc;
     }
-}
\ No newline at end of file
+}
+
+#ifdef FRAMEBUFFER_SIMD
+
+// 4 pixels at a time: color and depth are interpolated, tested and converted in SSE registers
+void FrameBuffer::DrawSpanSSE2(float * depth, unsigned char * color, int count, float r, float g, float b, float z, float rInc, float gInc, float bInc, float zInc)
+{
+    const __m128 steps = _mm_set_ps(3.f, 2.f, 1.f, 0.f);
+    const __m128 scale = _mm_set1_ps(255.99f);
+    const __m128 zero  = _mm_setzero_ps();
+    const __m128 max   = _mm_set1_ps(255.f);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+    __m128 rv = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(r), _mm_mul_ps(steps, _mm_set1_ps(rInc))), scale);
+    __m128 gv = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(g), _mm_mul_ps(steps, _mm_set1_ps(gInc))), scale);
+    __m128 bv = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(b), _mm_mul_ps(steps, _mm_set1_ps(bInc))), scale);
+    __m128 zv = _mm_add_ps(_mm_set1_ps(z), _mm_mul_ps(steps, _mm_set1_ps(zInc)));
+
+    const __m128 rStep = _mm_set1_ps(4.f * rInc * 255.99f);
+    const __m128 gStep = _mm_set1_ps(4.f * gInc * 255.99f);
+    const __m128 bStep = _mm_set1_ps(4.f * bInc * 255.99f);
+    const __m128 zStep = _mm_set1_ps(4.f * zInc);
+
+    int x = 0;
+    for (; x + 3 < count; x += 4)
+    {
+        // Depth test, keeping the closest value
+        __m128 stored = _mm_loadu_ps(depth + x);
+        __m128 pass   = _mm_cmplt_ps(zv, stored);
+        int    mask   = _mm_movemask_ps(pass);
+
+        if (mask)
+        {
+            _mm_storeu_ps(depth + x, _mm_or_ps(_mm_and_ps(pass, zv), _mm_andnot_ps(pass, stored)));
+
+            // Convert to bytes and pack as 0xFFBBGGRR, the RGBA bytes of the pixel
+            __m128i ri     = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(rv, zero), max));
+            __m128i gi     = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(gv, zero), max));
+            __m128i bi     = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(bv, zero), max));
+            __m128i packed = _mm_or_si128(_mm_or_si128(ri, alpha), _mm_or_si128(_mm_slli_epi32(gi, 8), _mm_slli_epi32(bi, 16)));
+
+            // One pixel per lane, the ones that failed the depth test keep their color
+            __m128i * dst      = reinterpret_cast<__m128i *>(color + 4 * x);
+            __m128i   passMask = _mm_castps_si128(pass);
+            __m128i   old      = _mm_loadu_si128(dst);
+            _mm_storeu_si128(dst, _mm_or_si128(_mm_and_si128(passMask, packed), _mm_andnot_si128(passMask, old)));
+        }
+
+        rv = _mm_add_ps(rv, rStep);
+        gv = _mm_add_ps(gv, gStep);
+        bv = _mm_add_ps(bv, bStep);
+        zv = _mm_add_ps(zv, zStep);
+    }
+
+    // Remaining pixels
+    if (x < count)
+    {
+        float offset = static_cast<float>(x);
+        DrawSpanScalar(depth + x, color + 4 * x, count - x, r + rInc * offset, g + gInc * offset, b + bInc * offset, z + zInc * offset, rInc, gInc, bInc, zInc);
+    }
+}
+
+// 8 pixels at a time, the RGBA pixels are blended with the depth test mask
+TARGET_AVX2 void FrameBuffer::DrawSpanAVX2(float * depth, unsigned char * color, int count, float r, float g, float b, float z, float rInc, float gInc, float bInc, float zInc)
+{
+    const __m256 steps = _mm256_set_ps(7.f, 6.f, 5.f, 4.f, 3.f, 2.f, 1.f, 0.f);
+    const __m256 scale = _mm256_set1_ps(255.99f);
+    const __m256 zero  = _mm256_setzero_ps();
+    const __m256 max   = _mm256_set1_ps(255.f);
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+
+    __m256 rv = _mm256_mul_ps(_mm256_add_ps(_mm256_set1_ps(r), _mm256_mul_ps(steps, _mm256_set1_ps(rInc))), scale);
+    __m256 gv = _mm256_mul_ps(_mm256_add_ps(_mm256_set1_ps(g), _mm256_mul_ps(steps, _mm256_set1_ps(gInc))), scale);
+    __m256 bv = _mm256_mul_ps(_mm256_add_ps(_mm256_set1_ps(b), _mm256_mul_ps(steps, _mm256_set1_ps(bInc))), scale);
+    __m256 zv = _mm256_add_ps(_mm256_set1_ps(z), _mm256_mul_ps(steps, _mm256_set1_ps(zInc)));
+
+    const __m256 rStep = _mm256_set1_ps(8.f * rInc * 255.99f);
+    const __m256 gStep = _mm256_set1_ps(8.f * gInc * 255.99f);
+    const __m256 bStep = _mm256_set1_ps(8.f * bInc * 255.99f);
+    const __m256 zStep = _mm256_set1_ps(8.f * zInc);
+
+    int x = 0;
+    for (; x + 7 < count; x += 8)
+    {
+        // Depth test, keeping the closest value
+        __m256 stored = _mm256_loadu_ps(depth + x);
+        __m256 pass   = _mm256_cmp_ps(zv, stored, _CMP_LT_OQ);
+        int    mask   = _mm256_movemask_ps(pass);
+
+        if (mask)
+        {
+            _mm256_storeu_ps(depth + x, _mm256_blendv_ps(stored, zv, pass));
+
+            // Convert to bytes and pack as 0xFFBBGGRR, the RGBA bytes of the pixel
+            __m256i ri     = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(rv, zero), max));
+            __m256i gi     = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(gv, zero), max));
+            __m256i bi     = _mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(bv, zero), max));
+            __m256i packed = _mm256_or_si256(_mm256_or_si256(ri, alpha), _mm256_or_si256(_mm256_slli_epi32(gi, 8), _mm256_slli_epi32(bi, 16)));
+
+            // Fully covered blocks are stored as they are, the others keep the pixels that failed
+            __m256i * dst = reinterpret_cast<__m256i *>(color + 4 * x);
+            if (mask == 0xFF)
+                _mm256_storeu_si256(dst, packed);
+            else
+                _mm256_storeu_si256(dst, _mm256_blendv_epi8(_mm256_loadu_si256(dst), packed, _mm256_castps_si256(pass)));
+        }
+
+        rv = _mm256_add_ps(rv, rStep);
+        gv = _mm256_add_ps(gv, gStep);
+        bv = _mm256_add_ps(bv, bStep);
+        zv = _mm256_add_ps(zv, zStep);
+    }
+
+    // Remaining pixels
+    if (x < count)
+    {
+        float offset = static_cast<float>(x);
+        DrawSpanSSE2(depth + x, color + 4 * x, count - x, r + rInc * offset, g + gInc * offset, b + bInc * offset, z + zInc * offset, rInc, gInc, bInc, zInc);
+    }
+}
+
+#else
+
+void FrameBuffer::DrawSpanSSE2(float * depth, unsigned char * color, int count, float r, float g, float b, float z, float rInc, float gInc, float bInc, float zInc)
+{
+    DrawSpanScalar(depth, color, count, r, g, b, z, rInc, gInc, bInc, zInc);
+}
+
+void FrameBuffer::DrawSpanAVX2(float * depth, unsigned char * color, int count, float r, float g, float b, float z, float rInc, float gInc, float bInc, float zInc)
+{
+    DrawSpanScalar(depth, color, count, r, g, b, z, rInc, gInc, bInc, zInc);
+}
+
+#endif
+
+// Linear RGBA rows of the color
+// In the tiled layout every row of a tile is copied to its place in the linear buffer
+const unsigned char * FrameBuffer::Resolve()
+{
+    if (layout == LAYOUT_LINEAR || imageData == nullptr)
+        return imageData;
+
+    const size_t rowBytes = 4 * static_cast<size_t>(width);
+
+    for (int y = 0; y < height; y++)
+    {
+        unsigned char * dst = resolveData + y * rowBytes;
+
+        // Whole tile rows, and what is left of the last tile (the padding is not copied).
+        // std::min takes references, +TILE_SIZE passes a copy so C++14 needs no definition
+        for (int x = 0; x < width; x += TILE_SIZE)
+        {
+            int pixels = std::min(+TILE_SIZE, width - x);
+            memcpy(dst + 4 * x, imageData + 4 * PixelIndex(x, y), 4 * pixels);
+        }
+    }
+
+    return resolveData;
+}
+
+// Upload the framebuffer to a texture of the same size
+// The rows are already RGBA as SFML expects them, so it is a single copy (after the resolve)
+void FrameBuffer::UpdateTexture(sf::Texture & texture)
+{
+    const unsigned char * pixels = Resolve();
+    if (pixels == nullptr)
+        return;
+
+    texture.update(pixels);
+}
+
+// Save the framebuffer as a binary PPM (P6) file
+bool FrameBuffer::SaveToPPM(const char * filename)
+{
+    FILE * out;
+    fopen_s(&out, filename, "wb");
+    const unsigned char * pixels = Resolve();
+    if (!out || pixels == nullptr)
+    {
+        if (out)
+            fclose(out);
+        return false;
+    }
+
+    // The rows are RGBA, the alpha is dropped a row at a time
+    fprintf(out, "P6\n%d %d\n255\n", width, height);
+    std::vector<unsigned char> row(static_cast<size_t>(3) * width);
+    bool written = true;
+
+    for (int y = 0; y < height && written; y++)
+    {
+        const unsigned char * src = pixels + static_cast<size_t>(4) * y * width;
+        for (int x = 0; x < width; x++)
+        {
+            row[3 * x]     = src[4 * x];
+            row[3 * x + 1] = src[4 * x + 1];
+            row[3 * x + 2] = src[4 * x + 2];
+        }
+
+        written = fwrite(row.data(), 1, row.size(), out) == row.size();
+    }
+
+    fclose(out);
+    return written;
+}
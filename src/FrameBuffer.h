@@ -1,22 +1,117 @@
 #pragma once
 #include <SFML/Graphics.hpp>
 
+// Render target: a color plane and an optional depth plane of the same size.
+// Every instance owns its planes, so several targets can be drawn at the same time
+// (one per thread, offscreen views...) as long as each one is used by one thread.
 class FrameBuffer
 {
   public:
-    static void Init(int w, int h);
-    static void Free();
+    // Memory layout of the color and depth planes:
+    // LAYOUT_LINEAR stores whole rows one after the other.
+    // LAYOUT_TILED stores blocks of TILE_SIZE x TILE_SIZE pixels contiguously (rows inside
+    // a block, blocks in row order), so a small triangle only touches a few cache lines.
+    // The tiled planes are resolved to linear rows when the frame is presented.
+    enum Layout { LAYOUT_LINEAR, LAYOUT_TILED };
 
-    static void Clear(unsigned char r = 0, unsigned char g = 0, unsigned char b = 0);
-    static void SetPixel(int x, int y, unsigned char r, unsigned char g, unsigned char b);
-    static void GetPixel(int x, int y, unsigned char & r, unsigned char & g, unsigned char & b);
-    static int  GetWidth() { return width; }
-    static int  GetHeight() { return height; }
+    static constexpr int TILE_SHIFT = 3;
+    static constexpr int TILE_SIZE  = 1 << TILE_SHIFT;    // Same as the tiles of Rasterizer::DrawTriangleTiled
 
-    static void ConvertFrameBufferToSFMLImage(sf::Image & image);
+    // Value the depth is cleared to, and what GetDepth returns outside of the plane or
+    // without one. Every byte is 0x7F, so the clear is a memset, and it is just below
+    // the largest float, farther than anything the projection gives
+    static constexpr float FAR_DEPTH = 3.39615136e+38f;
+
+    FrameBuffer() = default;
+    FrameBuffer(int w, int h, Layout l = LAYOUT_LINEAR, bool depth = true);
+    ~FrameBuffer();
+
+    // The planes are owned, a target cannot be copied
+    FrameBuffer(const FrameBuffer &) = delete;
+    FrameBuffer & operator=(const FrameBuffer &) = delete;
+
+    // Without a depth plane every depth test passes, and the pixels are just written
+    void Init(int w, int h, Layout l = LAYOUT_LINEAR, bool depth = true);
+    void Free();
+
+    void Clear(unsigned char r = 0, unsigned char g = 0, unsigned char b = 0);
+    void ClearColor(unsigned char r, unsigned char g, unsigned char b);
+    void ClearDepth(float z);
+    void SetPixel(int x, int y, unsigned char r, unsigned char g, unsigned char b);
+    void GetPixel(int x, int y, unsigned char & r, unsigned char & g, unsigned char & b) const;
+    bool DepthTest(int x, int y, float z);
+    float GetDepth(int x, int y) const;
+
+    // Same as DepthTest and SetPixel without the bounds check, for the rasterizers
+    // that only generate pixels inside the screen (0 <= x < width, 0 <= y < height)
+    bool DepthTestUnchecked(int x, int y, float z)
+    {
+        if (depthData == nullptr)
+            return true;
+
+        float & depth = depthData[PixelIndex(x, y)];
+        if (z >= depth)
+            return false;
+
+        depth = z;
+        return true;
+    }
+    void SetPixelUnchecked(int x, int y, unsigned char r, unsigned char g, unsigned char b)
+    {
+        unsigned char * pixel = imageData + 4 * PixelIndex(x, y);
+        pixel[0] = r;
+        pixel[1] = g;
+        pixel[2] = b;
+        pixel[3] = 255;
+    }
+
+    // Depth tests and writes the pixels x0..x1 (inclusive) of row y, starting from the
+    // given color (0 to 1) and depth and adding the increments at every pixel.
+    // Uses the widest SIMD version the CPU supports, selected once for all the targets.
+    void DrawSpan(int y, int x0, int x1, float r, float g, float b, float z, float rInc, float gInc, float bInc, float zInc);
+    static const char * GetSpanWriterName() { return spanWriterName; }
+    int    GetWidth() const { return width; }
+    int    GetHeight() const { return height; }
+    Layout GetLayout() const { return layout; }
+    bool   HasDepth() const { return depthData != nullptr; }
+
+    // The color as RGBA rows (alpha always 255), the layout sf::Texture::update takes.
+    // It is the buffer itself in the linear layout, and a copy resolved from the tiles otherwise
+    const unsigned char * Resolve();
+    void UpdateTexture(sf::Texture & texture);
+    bool SaveToPPM(const char * filename);
 
   private:
-    static int             width;
-    static int             height;
-    static unsigned char * imageData;
+    typedef void (*SpanWriter)(float *, unsigned char *, int, float, float, float, float, float, float, float, float);
+
+    // Write count pixels starting at the given depth and color, which are contiguous
+    static void DrawSpanScalar(float * depth, unsigned char * color, int count, float r, float g, float b, float z, float rInc, float gInc, float bInc, float zInc);
+    static void DrawSpanSSE2(float * depth, unsigned char * color, int count, float r, float g, float b, float z, float rInc, float gInc, float bInc, float zInc);
+    static void DrawSpanAVX2(float * depth, unsigned char * color, int count, float r, float g, float b, float z, float rInc, float gInc, float bInc, float zInc);
+    static void DrawSpanNoDepth(float * depth, unsigned char * color, int count, float r, float g, float b, float z, float rInc, float gInc, float bInc, float zInc);
+
+    static SpanWriter SelectSpanWriter(const char ** name);
+
+    // Position of pixel (x, y) in the planes
+    size_t PixelIndex(int x, int y) const
+    {
+        if (layout == LAYOUT_LINEAR)
+            return static_cast<size_t>(y) * width + x;
+
+        size_t tile = static_cast<size_t>(y >> TILE_SHIFT) * tilesX + (x >> TILE_SHIFT);
+        return (tile << (2 * TILE_SHIFT)) + ((y & (TILE_SIZE - 1)) << TILE_SHIFT) + (x & (TILE_SIZE - 1));
+    }
+
+    static const char * spanWriterName;
+    static SpanWriter   spanWriter;
+
+    Layout          layout      = LAYOUT_LINEAR;
+    int             width       = 0;
+    int             height      = 0;
+    int             tilesX      = 0;            // Blocks per row, in the tiled layout
+    int             tilesY      = 0;
+    size_t          pixelCount  = 0;            // Pixels in each plane, with the padding of the tiles
+    unsigned char * imageData   = nullptr;
+    float *         depthData   = nullptr;      // Null without a depth plane
+    unsigned char * resolveData = nullptr;      // Linear copy of the color, in the tiled layout
 };
@@ -0,0 +1,135 @@
+#include "Affine4.h"			//Header file
+#include "MathUtilities.h"		//Helper macros
+#include "Quaternion.h"
+
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<Affine4>::value, "Affine4 must be trivially copyable");
+
+//Compile-time checks, the constexpr functions must give the expected results
+static constexpr Affine4 checkTRS(0.f, -2.f, 0.f, 5.f, 2.f, 0.f, 0.f, -3.f, 0.f, 0.f, 2.f, 1.f);
+static constexpr Matrix4 checkProj(1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 0.f, -1.f, 0.f, 0.f, -0.5f, 0.f);
+
+static_assert(checkTRS * checkTRS.Inverse() == Affine4::IdentityMatrix(), "Affine4 inverse");
+static_assert(checkTRS.Inverse() * checkTRS == Affine4::IdentityMatrix(), "Affine4 inverse on the left");
+static_assert((checkTRS * checkTRS).ToMatrix4() == checkTRS.ToMatrix4() * checkTRS.ToMatrix4(), "Affine4 multiplication");
+static_assert(checkProj * checkTRS == checkProj * checkTRS.ToMatrix4(), "Matrix4 times Affine4");
+static_assert(checkTRS * Point4(1.f, 1.f, 1.f) == checkTRS.ToMatrix4() * Point4(1.f, 1.f, 1.f), "Affine4 times a point");
+static_assert(checkTRS * Vector4(1.f, 1.f, 1.f) == Vector4(-2.f, 2.f, 2.f), "Affine4 times a vector");
+static_assert(Affine4().Inverse() == Affine4(), "Affine4 singular inverse");
+
+//A small uniform scale has a tiny determinant (6.4e-8) but is still invertible
+static constexpr Affine4 checkSmall(0.004f, 0.f, 0.f, 1.f, 0.f, 0.004f, 0.f, 2.f, 0.f, 0.f, 0.004f, 3.f);
+
+static_assert(checkSmall * checkSmall.Inverse() == Affine4::IdentityMatrix(), "Affine4 inverse of a small scale");
+static_assert(checkSmall.Inverse().ToMatrix4() == checkSmall.ToMatrix4().AffineInverse(), "Affine4 inverse matches Matrix4");
+static_assert(checkTRS.Scaled(Vector4(2.f, 3.f, 4.f)) == checkTRS * Affine4(2.f, 0.f, 0.f, 0.f, 0.f, 3.f, 0.f, 0.f, 0.f, 0.f, 4.f, 0.f), "Affine4 scaled");
+
+/**
+* @brief  Builds T * RotZ * RotY * RotX * S in closed form
+*
+* @param translation:	position, the last column
+* @param rotation:		angles around x, y and z in radians
+* @param scale:			scale in x, y and z
+* @return mtx:			the whole transformation
+*/
+Affine4 Affine4::Compose(const Point4& translation, const Vector4& rotation, const Vector4& scale)
+{
+	//Sines and cosines of the 3 angles at once
+	float s[4], c[4];
+	SinCos4(rotation.v, s, c);
+
+	//RotZ * RotY * RotX, column by column
+	float r00 = c[2] * c[1];
+	float r10 = s[2] * c[1];
+	float r20 = -s[1];
+	float r01 = c[2] * s[1] * s[0] - s[2] * c[0];
+	float r11 = s[2] * s[1] * s[0] + c[2] * c[0];
+	float r21 = c[1] * s[0];
+	float r02 = c[2] * s[1] * c[0] + s[2] * s[0];
+	float r12 = s[2] * s[1] * c[0] - c[2] * s[0];
+	float r22 = c[1] * c[0];
+
+	//The scale multiplies the columns, the translation is the last one
+	return Affine4(r00 * scale.x, r01 * scale.y, r02 * scale.z, translation.x,
+	               r10 * scale.x, r11 * scale.y, r12 * scale.z, translation.y,
+	               r20 * scale.x, r21 * scale.y, r22 * scale.z, translation.z);
+}
+
+/**
+* @brief  Builds T * R * S in closed form, R given by a quaternion
+*
+* @param translation:	position, the last column
+* @param rotation:		orientation, length 1
+* @param scale:			scale in x, y and z
+* @return mtx:			the whole transformation
+*/
+Affine4 Affine4::Compose(const Point4& translation, const Quaternion& rotation, const Vector4& scale)
+{
+	Affine4 mtx = rotation.ToAffine4().Scaled(scale);
+	mtx.m[0][3] = translation.x;
+	mtx.m[1][3] = translation.y;
+	mtx.m[2][3] = translation.z;
+
+	return mtx;
+}
+
+#ifdef MATH_SSE
+
+/**
+* @brief  Multiplication of 2 affine matrices with SSE
+*
+* @param lhs:		matrix on the left
+* @param rhs:		matrix on the right
+* @return mtx:		result of the multiplication
+*/
+Affine4 Affine4::ConcatenateSSE(const Affine4& lhs, const Affine4& rhs)
+{
+	Affine4 mtx;
+
+	//Every row of the result is a combination of the rows of rhs, the last one is 0,0,0,1
+	__m128 b0 = _mm_load_ps(rhs.m[0]);
+	__m128 b1 = _mm_load_ps(rhs.m[1]);
+	__m128 b2 = _mm_load_ps(rhs.m[2]);
+
+	for (int i = 0; i < 3; i++)
+	{
+		__m128 row = _mm_mul_ps(_mm_set1_ps(lhs.m[i][0]), b0);
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs.m[i][1]), b1));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs.m[i][2]), b2));
+		row = _mm_add_ps(row, _mm_set_ps(lhs.m[i][3], 0.f, 0.f, 0.f));
+		_mm_store_ps(mtx.m[i], row);
+	}
+
+	return mtx;
+}
+
+/**
+* @brief  Multiplication of a full matrix and an affine one with SSE
+*
+* @param lhs:		full matrix on the left
+* @param rhs:		affine matrix on the right
+* @return mtx:		result of the multiplication
+*/
+Matrix4 Affine4::ConcatenateSSE(const Matrix4& lhs, const Affine4& rhs)
+{
+	Matrix4 mtx;
+
+	//Same as above with 4 rows
+	__m128 b0 = _mm_load_ps(rhs.m[0]);
+	__m128 b1 = _mm_load_ps(rhs.m[1]);
+	__m128 b2 = _mm_load_ps(rhs.m[2]);
+
+	for (int i = 0; i < 4; i++)
+	{
+		__m128 row = _mm_mul_ps(_mm_set1_ps(lhs.m[i][0]), b0);
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs.m[i][1]), b1));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs.m[i][2]), b2));
+		row = _mm_add_ps(row, _mm_set_ps(lhs.m[i][3], 0.f, 0.f, 0.f));
+		_mm_store_ps(mtx.m[i], row);
+	}
+
+	return mtx;
+}
+
+#endif
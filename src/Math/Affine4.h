@@ -0,0 +1,360 @@
+#ifndef AFFINE4_H
+#define AFFINE4_H
+
+#include <cstdio>              // printf
+#include "Vector4.h"
+#include "Point4.h"
+#include "Matrix4.h"
+#include "MathUtilities.h"
+
+class Quaternion;
+
+// 4x4 matrix whose last row is always 0,0,0,1 (rotations, translations, scales and their
+// products), so only the first 3 rows are stored and multiplied
+class alignas(16) Affine4
+{
+    public:
+
+        union
+        {
+            float m[3][4];
+            float v[12];
+        };
+        /*
+            This union lets us access the data in multiple ways
+            All of these are modifying the same location in memory
+            Affine4 mtx;
+            mtx.m[2][2] = 1.0f;
+            mtx.v[10] = 2.0f;
+        */
+
+        // Default constructor, initializes the 3 rows to zeroes
+        constexpr Affine4(void) : m{} {}
+
+        // Non-default constructor, the 3 rows (the last one is 0,0,0,1)
+        constexpr Affine4(float mm00, float mm01, float mm02, float mm03,
+        float mm10, float mm11, float mm12, float mm13,
+        float mm20, float mm21, float mm22, float mm23)
+            : m{{mm00, mm01, mm02, mm03},
+                {mm10, mm11, mm12, mm13},
+                {mm20, mm21, mm22, mm23}} {}
+
+        // Copy and move are plain memberwise copies, so the class is trivially copyable
+        Affine4(const Affine4& rhs) = default;
+        Affine4(Affine4&& rhs) = default;
+        Affine4& operator=(const Affine4& rhs) = default;
+        Affine4& operator=(Affine4&& rhs) = default;
+
+        // Multiplying with a Vector4 or a Point4, w is kept as it is
+        constexpr Vector4 operator*(const Vector4& rhs) const;
+        constexpr Point4 operator*(const Point4& rhs) const;
+
+        // Concatenation, the result is affine too
+        constexpr Affine4 operator*(const Affine4& rhs) const;
+        constexpr Affine4& operator*=(const Affine4& rhs);
+
+        // Comparison operators which should use an epsilon defined in
+        // MathUtilities.h to see if the value is within a certain range
+        // in which case we say they are equivalent.
+        constexpr bool operator==(const Affine4& rhs) const;
+        constexpr bool operator!=(const Affine4& rhs) const;
+
+        // Inverse of the transformation, the zero matrix if it can't be inverted
+        constexpr Affine4 Inverse(void) const;
+
+        // Full 4x4 version of the matrix
+        constexpr Matrix4 ToMatrix4(void) const;
+
+        // Builds T * RotZ * RotY * RotX * S directly, with one sincos for the 3 angles (radians)
+        static Affine4 Compose(const Point4& translation, const Vector4& rotation, const Vector4& scale);
+        // Same with the rotation given as a quaternion of length 1, no sin/cos needed
+        static Affine4 Compose(const Point4& translation, const Quaternion& rotation, const Vector4& scale);
+        // Same as multiplying by a scale matrix on the right, scales the first 3 columns
+        constexpr Affine4 Scaled(const Vector4& scale) const;
+
+        // Zeroes out the 3 rows
+        constexpr void Zero(void);
+
+        // Builds the identity matrix
+        constexpr void Identity(void);
+        // Returns an identity matrix, can be used to build constants at compile time
+        static constexpr Affine4 IdentityMatrix(void);
+
+        // Simple print function
+        void Print(void) const
+        {
+            std::printf("--------------------------\n");
+            std::printf("%5.3f %5.3f %5.3f %5.3f\n", m[0][0], m[0][1], m[0][2], m[0][3]);
+            std::printf("%5.3f %5.3f %5.3f %5.3f\n", m[1][0], m[1][1], m[1][2], m[1][3]);
+            std::printf("%5.3f %5.3f %5.3f %5.3f\n", m[2][0], m[2][1], m[2][2], m[2][3]);
+            std::printf("%5.3f %5.3f %5.3f %5.3f\n", 0.0f, 0.0f, 0.0f, 1.0f);
+            std::printf("--------------------------\n");
+        }
+
+        // Full matrix times affine matrix (the projection times the model to world)
+        friend constexpr Matrix4 operator*(const Matrix4& lhs, const Affine4& rhs);
+
+    private:
+
+#ifdef MATH_SSE
+        // SSE versions of the concatenations, only used outside of constant expressions
+        static Affine4 ConcatenateSSE(const Affine4& lhs, const Affine4& rhs);
+        static Matrix4 ConcatenateSSE(const Matrix4& lhs, const Affine4& rhs);
+#endif
+};
+
+/*
+    Everything is constexpr, so it is defined here. Constant expressions can only
+    read the array that was initialized (m), never v
+*/
+
+/**
+* @brief  Multiplying with a Vector4, the last row is 0,0,0,1
+*
+* @param rhs:       vector to multiply
+* @return vec:      result of the multiplication
+*/
+constexpr Vector4 Affine4::operator*(const Vector4& rhs) const
+{
+    Vector4 vec;
+
+    //Only the 3 stored rows, w does not change
+    for (int i = 0; i < 3; i++)
+        vec.v[i] = m[i][0] * rhs.v[0] + m[i][1] * rhs.v[1] + m[i][2] * rhs.v[2] + m[i][3] * rhs.v[3];
+    vec.v[3] = rhs.v[3];
+
+    return vec;
+}
+
+/**
+* @brief  Multiplying with a Point4, the last row is 0,0,0,1
+*
+* @param rhs:       point to multiply
+* @return point:    result of the multiplication
+*/
+constexpr Point4 Affine4::operator*(const Point4& rhs) const
+{
+    Point4 point;
+
+    //Only the 3 stored rows, w does not change
+    for (int i = 0; i < 3; i++)
+        point.v[i] = m[i][0] * rhs.v[0] + m[i][1] * rhs.v[1] + m[i][2] * rhs.v[2] + m[i][3] * rhs.v[3];
+    point.v[3] = rhs.v[3];
+
+    return point;
+}
+
+/**
+* @brief  Multiplication of 2 affine matrices, 36 products instead of 64
+*
+* @param rhs:       matrix to multiply
+* @return mtx:      result of the multiplication
+*/
+constexpr Affine4 Affine4::operator*(const Affine4& rhs) const
+{
+#ifdef MATH_SSE
+    if (!MATH_CONSTANT_EVALUATED())
+        return ConcatenateSSE(*this, rhs);
+#endif
+
+    //The last row of rhs is 0,0,0,1, so it only adds the translation
+    Affine4 mtx;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            mtx.m[i][j] = m[i][0] * rhs.m[0][j] + m[i][1] * rhs.m[1][j] + m[i][2] * rhs.m[2][j];
+        }
+        mtx.m[i][3] += m[i][3];
+    }
+
+    return mtx;
+}
+
+/**
+* @brief  Multiplication of 2 affine matrices
+*
+* @param rhs:       matrix to multiply
+* @return *this:    altered matrix with result of the multiplication
+*/
+constexpr Affine4& Affine4::operator*=(const Affine4& rhs)
+{
+    //Multiply the matrices
+    *this = *this * rhs;
+    return *this;
+}
+
+/**
+* @brief  Multiplication of a full matrix and an affine one, only the last row of rhs is skipped
+*
+* @param lhs:       full matrix
+* @param rhs:       affine matrix
+* @return mtx:      result of the multiplication
+*/
+constexpr Matrix4 operator*(const Matrix4& lhs, const Affine4& rhs)
+{
+#ifdef MATH_SSE
+    if (!MATH_CONSTANT_EVALUATED())
+        return Affine4::ConcatenateSSE(lhs, rhs);
+#endif
+
+    //The last row of rhs is 0,0,0,1, so it only adds the last column of lhs
+    Matrix4 mtx;
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            mtx.m[i][j] = lhs.m[i][0] * rhs.m[0][j] + lhs.m[i][1] * rhs.m[1][j] + lhs.m[i][2] * rhs.m[2][j];
+        }
+        mtx.m[i][3] += lhs.m[i][3];
+    }
+
+    return mtx;
+}
+
+/**
+* @brief Comparison operator, should use funciton from MathUtilities.h
+*
+* @param rhs:           matrix to compare
+* @return true/false:   whether the matrices are equal
+*/
+constexpr bool Affine4::operator==(const Affine4& rhs) const
+{
+    //Compare values in the matrix using macro function
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            if (!isEqual(m[i][j], rhs.m[i][j]))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+* @brief Comparison operator
+*
+* @param rhs:           marix to compare
+* @return true/false:   whether the matrices are different
+*/
+constexpr bool Affine4::operator!=(const Affine4& rhs) const
+{
+    //Compare matrices
+    return !(*this == rhs);
+}
+
+/**
+* @brief  Inverse of the transformation: the inverse of the 3x3 part, and the
+*         translation moved back by it
+*
+* @param (void)
+* @return inv:      the inverse, or the zero matrix if the determinant is zero
+*/
+constexpr Affine4 Affine4::Inverse(void) const
+{
+    //Cofactors of the 3x3 part
+    float c00 = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    float c01 = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    float c02 = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+
+    float det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+    if (det == 0.f)
+        return Affine4();
+
+    float invDet = 1.0f / det;
+
+    //Transposed cofactors over the determinant
+    Affine4 inv;
+    inv.m[0][0] = c00 * invDet;
+    inv.m[1][0] = c01 * invDet;
+    inv.m[2][0] = c02 * invDet;
+    inv.m[0][1] = (m[0][2] * m[2][1] - m[0][1] * m[2][2]) * invDet;
+    inv.m[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[2][0]) * invDet;
+    inv.m[2][1] = (m[0][1] * m[2][0] - m[0][0] * m[2][1]) * invDet;
+    inv.m[0][2] = (m[0][1] * m[1][2] - m[0][2] * m[1][1]) * invDet;
+    inv.m[1][2] = (m[0][2] * m[1][0] - m[0][0] * m[1][2]) * invDet;
+    inv.m[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[1][0]) * invDet;
+
+    //Undo the translation in the inverted frame
+    for (int i = 0; i < 3; i++)
+        inv.m[i][3] = -(inv.m[i][0] * m[0][3] + inv.m[i][1] * m[1][3] + inv.m[i][2] * m[2][3]);
+
+    return inv;
+}
+
+/**
+* @brief  Full 4x4 version of the matrix
+*
+* @param (void)
+* @return mtx:      the same matrix with the 0,0,0,1 row
+*/
+constexpr Matrix4 Affine4::ToMatrix4(void) const
+{
+    return Matrix4(m[0][0], m[0][1], m[0][2], m[0][3],
+                   m[1][0], m[1][1], m[1][2], m[1][3],
+                   m[2][0], m[2][1], m[2][2], m[2][3],
+                   0.0f,    0.0f,    0.0f,    1.0f);
+}
+
+/**
+* @brief  Multiplies by a scale matrix on the right without building it
+*
+* @param scale:     scale in x, y and z
+* @return mtx:      the matrix with its first 3 columns scaled
+*/
+constexpr Affine4 Affine4::Scaled(const Vector4& scale) const
+{
+    Affine4 mtx;
+    for (int i = 0; i < 3; i++)
+    {
+        mtx.m[i][0] = m[i][0] * scale.v[0];
+        mtx.m[i][1] = m[i][1] * scale.v[1];
+        mtx.m[i][2] = m[i][2] * scale.v[2];
+        mtx.m[i][3] = m[i][3];
+    }
+
+    return mtx;
+}
+
+/**
+* @brief  Sets the 3 rows to zero
+*
+* @param (void)
+*/
+constexpr void Affine4::Zero(void)
+{
+    //Set everything to 0
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++)
+            m[i][j] = 0.0f;
+}
+
+/**
+* @brief  Builds the identity matrix
+*
+* @param (void)
+*/
+constexpr void Affine4::Identity(void)
+{
+    //Make a zero matrix and set the main diagonal to 1
+    Zero();
+    for (int i = 0; i < 3; i++)
+        m[i][i] = 1.0f;
+}
+
+/**
+* @brief  Returns an identity matrix
+*
+* @param (void)
+* @return mtx:      the identity matrix
+*/
+constexpr Affine4 Affine4::IdentityMatrix(void)
+{
+    return Affine4(1.0f, 0.0f, 0.0f, 0.0f,
+                   0.0f, 1.0f, 0.0f, 0.0f,
+                   0.0f, 0.0f, 1.0f, 0.0f);
+}
+
+#endif
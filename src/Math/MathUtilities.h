@@ -1,10 +1,149 @@
 #ifndef MATHUTILITIES_H
 #define MATHUTILITIES_H
 
+#include <cmath>
 #include <limits>
 
+// True while a constexpr function is evaluated at compile time, where the SSE versions
+// can't be used. Without the builtin the plain loops are always used
+#if defined(__GNUC__) || defined(__clang__) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+    #define MATH_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+    #define MATH_CONSTANT_EVALUATED() true
+    #ifndef MATH_NO_SIMD
+        #define MATH_NO_SIMD
+    #endif
+#endif
+
+// SSE backend for the math classes, the plain loops are used everywhere else
+#if !defined(MATH_NO_SIMD) && (defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__))
+    #define MATH_SSE
+    #include <emmintrin.h>
+#endif
+
+// Functions using AVX2 are compiled for it even if the rest of the program is not,
+// and must only be called when CpuHasAVX2() is true. They only exist on x64 (MATH_AVX2)
+#if defined(_M_X64) || defined(__x86_64__)
+    #define MATH_AVX2
+    #include <immintrin.h>
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #define TARGET_AVX2
+    #else
+        #define TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+// Whether the CPU (and the OS) support AVX2
+inline bool CpuHasAVX2()
+{
+#if (defined(_M_X64) || defined(__x86_64__)) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+
+    // AVX and OSXSAVE, then the OS must save the YMM registers
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0)
+        return false;
+    if ((_xgetbv(0) & 6) != 6)
+        return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#elif defined(_M_X64) || defined(__x86_64__)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+// Square root that can be used in constant expressions (Newton's method at compile time)
+constexpr float SquareRoot(float x)
+{
+    if (!MATH_CONSTANT_EVALUATED())
+        return std::sqrt(x);
+
+    //Zero, infinity and NaN are their own root
+    if (x == 0.f || x != x || x == std::numeric_limits<float>::infinity())
+        return x;
+    if (x < 0.f)
+        return std::numeric_limits<float>::quiet_NaN();
+
+    //Start above the root, every step gets closer until it stops decreasing
+    double root = x > 1.f ? x : 1.0;
+    for (int i = 0; i < 256; i++)
+    {
+        double next = 0.5 * (root + x / root);
+        if (next >= root)
+            break;
+        root = next;
+    }
+
+    return static_cast<float>(root);
+}
+
+// Sine and cosine of 4 angles (radians) at once. With SSE it is the Cephes polynomial
+// approximation (about 1e-7 error for |angle| < 8192), otherwise std::sin/std::cos
+inline void SinCos4(const float angles[4], float sines[4], float cosines[4])
+{
+#ifdef MATH_SSE
+    const __m128i one  = _mm_set1_epi32(1);
+    const __m128i two  = _mm_set1_epi32(2);
+    const __m128i four = _mm_set1_epi32(4);
+    const __m128  signMask = _mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+
+    //Work with |x|, the sine keeps the sign of the angle
+    __m128 x = _mm_loadu_ps(angles);
+    __m128 signSin = _mm_and_ps(x, signMask);
+    x = _mm_andnot_ps(signMask, x);
+
+    //Octant of the angle, rounded up to an even one
+    __m128i j = _mm_cvttps_epi32(_mm_mul_ps(x, _mm_set1_ps(1.27323954473516f)));
+    j = _mm_and_si128(_mm_add_epi32(j, one), _mm_set1_epi32(~1));
+    __m128 y = _mm_cvtepi32_ps(j);
+
+    //Sign swaps and which polynomial gives the sine
+    signSin = _mm_xor_ps(signSin, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, four), 29)));
+    __m128 signCos = _mm_castsi128_ps(_mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, two), four), 29));
+    __m128 polyMask = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, two), _mm_setzero_si128()));
+
+    //x - y * pi/4 in extended precision
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-0.78515625f)));
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-2.4187564849853515625e-4f)));
+    x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-3.77489497744594108e-8f)));
+    __m128 z = _mm_mul_ps(x, x);
+
+    //Cosine polynomial
+    __m128 c = _mm_set1_ps(2.443315711809948e-5f);
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(-1.388731625493765e-3f));
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(4.166664568298827e-2f));
+    c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+    c = _mm_add_ps(_mm_sub_ps(c, _mm_mul_ps(z, _mm_set1_ps(0.5f))), _mm_set1_ps(1.f));
+
+    //Sine polynomial
+    __m128 s = _mm_set1_ps(-1.9515295891e-4f);
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(8.3321608736e-3f));
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(-1.6666654611e-1f));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), x), x);
+
+    //Pick the polynomial for each result and apply the signs
+    __m128 sinRes = _mm_or_ps(_mm_and_ps(polyMask, s), _mm_andnot_ps(polyMask, c));
+    __m128 cosRes = _mm_or_ps(_mm_and_ps(polyMask, c), _mm_andnot_ps(polyMask, s));
+    _mm_storeu_ps(sines, _mm_xor_ps(sinRes, signSin));
+    _mm_storeu_ps(cosines, _mm_xor_ps(cosRes, signCos));
+#else
+    for (int i = 0; i < 4; i++)
+    {
+        sines[i]   = std::sin(angles[i]);
+        cosines[i] = std::cos(angles[i]);
+    }
+#endif
+}
+
 // Macro definitions
 #define isZero(x)     ((x < std::numeric_limits<float>::epsilon()) && (x > -std::numeric_limits<float>::epsilon()))
 #define isEqual(x, y) (((x >= y) ? (x - y) : (y - x)) < std::numeric_limits<float>::epsilon())
 
-#endif
\ No newline at end of file
+#endif
@@ -9,12 +9,11 @@
 \date   18/01/2022
 \brief
 
-This file contains the implementation of the following functions for the
-Math Library assignment.
-Functions include:	Matrix4 constructors, operator=, operator-, operator+,
-					operator- (negation), operator *, operator/, operator+=,
-					operator-=, operator*=, operator/=, operator==, operator!=,
-					Identity, Zero
+This file contains the SSE versions of the Matrix4 multiplications, the
+batch point transform and the compile-time checks of the Math Library
+assignment. The constexpr functions are defined in Matrix4.h.
+Functions include:	MultiplySSE, ConcatenateSSE, TransposeSSE, InverseSSE,
+					AffineInverseSSE, InverseTranspose3x3SSE, SelfTest, TransformPoints
 
 Hours spent on this assignment: ~10
 
@@ -24,331 +23,514 @@ Hours spent on this assignment: ~10
 #include "Matrix4.h"			//Header file
 #include "MathUtilities.h"		//Helper macros
 
+#include <type_traits>
 
-/**
-* @brief Default constructor, sets x,y,z to zero and w to the defined value
-*
-* @param (void)
-*/
-Matrix4::Matrix4(void)
-{
-	//Set all values to zero
-	for (int i = 0; i < 16; i++)
-		v[i] = 0.0f;
-}
+static_assert(std::is_trivially_copyable<Matrix4>::value, "Matrix4 must be trivially copyable");
 
-/**
-* @brief Copy constructor, copies every entry from the other matrix.
-*
-* @param rhs:	matrix to copy values from
-*/
-Matrix4::Matrix4(const Matrix4& rhs)
-{
-	//Set values
-	for (int i = 0; i < 16; i++)
-		v[i] = rhs.v[i];
-}
 
-/**
-* @brief Non-Default constructor, self-explanatory
+//Compile-time checks, the constexpr functions must give the expected results
+static constexpr Matrix4 checkA(1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f, 8.f, 9.f, 10.f, 11.f, 12.f, 13.f, 14.f, 15.f, 16.f);
+static constexpr Matrix4 checkSwapXY(0.f, 1.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f);
 
-*
-* @param mm00, mm01, mm02...:	values to set matrix to
-*/
-Matrix4::Matrix4(float mm00, float mm01, float mm02, float mm03,
-float mm10, float mm11, float mm12, float mm13,
-float mm20, float mm21, float mm22, float mm23,
-float mm30, float mm31, float mm32, float mm33)
-{
-	//Set values
-	m[0][0] = mm00;	m[0][1] = mm01;	m[0][2] = mm02; m[0][3] = mm03;
-	m[1][0] = mm10;	m[1][1] = mm11;	m[1][2] = mm12; m[1][3] = mm13;
-	m[2][0] = mm20;	m[2][1] = mm21;	m[2][2] = mm22; m[2][3] = mm23;
-	m[3][0] = mm30;	m[3][1] = mm31;	m[3][2] = mm32; m[3][3] = mm33;
-}
+static_assert(Matrix4::IdentityMatrix() * checkA == checkA && checkA * Matrix4::IdentityMatrix() == checkA, "Matrix4 identity");
+static_assert(checkSwapXY * checkSwapXY == Matrix4::IdentityMatrix(), "Matrix4 axis swap is its own inverse");
+static_assert(checkA * checkA == Matrix4(90.f, 100.f, 110.f, 120.f, 202.f, 228.f, 254.f, 280.f,
+                                         314.f, 356.f, 398.f, 440.f, 426.f, 484.f, 542.f, 600.f), "Matrix4 multiplication");
+static_assert(checkA + checkA == checkA * 2.f && (checkA * 2.f) / 2.f == checkA, "Matrix4 scaling");
+static_assert(checkA - checkA == Matrix4(), "Matrix4 substraction");
+static_assert(checkSwapXY * Point4(1.f, 2.f, 3.f) == Point4(2.f, 1.f, 3.f), "Matrix4 times a point");
+static_assert(checkA * Vector4(1.f, 0.f, 0.f) == Vector4(1.f, 5.f, 9.f, 13.f), "Matrix4 times a vector");
+static_assert(Matrix4::IdentityMatrix() != checkSwapXY, "Matrix4 comparison");
+
+static constexpr Matrix4 checkAffine(0.f, -2.f, 0.f, 5.f, 2.f, 0.f, 0.f, -3.f, 0.f, 0.f, 4.f, 1.f, 0.f, 0.f, 0.f, 1.f);
+static constexpr Matrix4 checkProj(1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 0.f, -1.f, 0.f, 0.f, -0.5f, 0.f);
+
+static_assert(checkA.Transpose() == Matrix4(1.f, 5.f, 9.f, 13.f, 2.f, 6.f, 10.f, 14.f, 3.f, 7.f, 11.f, 15.f, 4.f, 8.f, 12.f, 16.f), "Matrix4 transpose");
+static_assert(checkProj * checkProj.Inverse() == Matrix4::IdentityMatrix(), "Matrix4 inverse of a projection");
+static_assert(checkAffine.Inverse() * checkAffine == Matrix4::IdentityMatrix(), "Matrix4 inverse on the left");
+static_assert(checkAffine.AffineInverse() == checkAffine.Inverse(), "Matrix4 affine inverse");
+static_assert(checkAffine.InverseTranspose3x3() == Matrix4(0.f, -0.5f, 0.f, 0.f, 0.5f, 0.f, 0.f, 0.f, 0.f, 0.f, 0.25f, 0.f, 0.f, 0.f, 0.f, 1.f), "Matrix4 normal matrix");
+static_assert(checkA.Inverse() == Matrix4(), "Matrix4 singular inverse");
+
+#ifdef MATH_SSE
 
 /**
-* @brief Assignment operator, does not need to handle self-assignment
+* @brief  Multiplies the matrix by 4 floats (a vector or a point) with SSE
 *
-* @param rhs:		matrix to copy from
-* @return *this:	altered matrix
+* @param mtx:		matrix to multiply by
+* @param in:		the 4 coordinates, 16 byte aligned
+* @param out:		result of the multiplication, 16 byte aligned
 */
-Matrix4& Matrix4::operator=(const Matrix4& rhs)
+void Matrix4::MultiplySSE(const Matrix4& mtx, const float* in, float* out)
 {
-	//Change values if they are different matrices
-	if(*this != rhs)
-		for (int i = 0; i < 16; i++)
-			v[i] = rhs.v[i];
-
-	return *this;
+	//Multiply every row by the vector, then add the rows up by transposing
+	__m128 vr = _mm_load_ps(in);
+	__m128 r0 = _mm_mul_ps(_mm_load_ps(mtx.m[0]), vr);
+	__m128 r1 = _mm_mul_ps(_mm_load_ps(mtx.m[1]), vr);
+	__m128 r2 = _mm_mul_ps(_mm_load_ps(mtx.m[2]), vr);
+	__m128 r3 = _mm_mul_ps(_mm_load_ps(mtx.m[3]), vr);
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+	_mm_store_ps(out, _mm_add_ps(_mm_add_ps(_mm_add_ps(r0, r1), r2), r3));
 }
 
 /**
-* @brief  Multiplying a Matrix4 with a Vector4
+* @brief  Multiplication of 2 matrices with SSE
 *
-* @param rhs:		vector to multiply
-* @return vec:		result of the multiplication
+* @param lhs:		matrix on the left
+* @param rhs:		matrix on the right
+* @return mtx:		result of the multiplication
 */
-Vector4 Matrix4::operator*(const Vector4& rhs) const
+Matrix4 Matrix4::ConcatenateSSE(const Matrix4& lhs, const Matrix4& rhs)
 {
-	Vector4 vec;
+	Matrix4 mtx;
+
+	//Every row of the result is a combination of the rows of rhs
+	__m128 b0 = _mm_load_ps(rhs.m[0]);
+	__m128 b1 = _mm_load_ps(rhs.m[1]);
+	__m128 b2 = _mm_load_ps(rhs.m[2]);
+	__m128 b3 = _mm_load_ps(rhs.m[3]);
 
-	//Do the multiplication
 	for (int i = 0; i < 4; i++)
 	{
-		for (int j = 0; j < 4; j++)
-		{
-			vec.v[i] += m[i][j] * rhs.v[j];
-		}
+		__m128 row = _mm_mul_ps(_mm_set1_ps(lhs.m[i][0]), b0);
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs.m[i][1]), b1));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs.m[i][2]), b2));
+		row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(lhs.m[i][3]), b3));
+		_mm_store_ps(mtx.m[i], row);
 	}
 
-	return vec;
+	return mtx;
 }
 
 /**
-* @brief  Multiplying a Matrix4 with a Point4
+* @brief  Transposed copy of the matrix with SSE
 *
-* @param rhs:		point to multiply
-* @return point:		result of the multiplication
+* @param mtx:		matrix to transpose
+* @return res:		rows and columns swapped
 */
-Point4 Matrix4::operator*(const Point4& rhs) const
+Matrix4 Matrix4::TransposeSSE(const Matrix4& mtx)
 {
-	Point4 point;
-	point.w = 0.f;
-
-	//Do the multiplication
-	for (int i = 0; i < 4; i++)
-	{
-		for (int j = 0; j < 4; j++)
-		{
-			point.v[i] += m[i][j] * rhs.v[j];
-		}
-	}
-
-	return point;
+	__m128 r0 = _mm_load_ps(mtx.m[0]);
+	__m128 r1 = _mm_load_ps(mtx.m[1]);
+	__m128 r2 = _mm_load_ps(mtx.m[2]);
+	__m128 r3 = _mm_load_ps(mtx.m[3]);
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+	Matrix4 res;
+	_mm_store_ps(res.m[0], r0);
+	_mm_store_ps(res.m[1], r1);
+	_mm_store_ps(res.m[2], r2);
+	_mm_store_ps(res.m[3], r3);
+
+	return res;
 }
 
+//Shuffles with the lanes in memory order
+#define SHUFFLE(a, b, x, y, z, w)	_mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+#define SWIZZLE(a, x, y, z, w)		SHUFFLE(a, a, x, y, z, w)
 
 /**
-* @brief  Addition of 2 matrices
+* @brief  Product of 2 2x2 matrices stored in a register (row major)
 *
-* @param rhs:		matrix to add
-* @return mtx:		result of the addition
+* @param a, b:		matrices to multiply
+* @return:			a * b
 */
-Matrix4 Matrix4::operator+(const Matrix4& rhs) const
+static inline __m128 Mat2Mul(__m128 a, __m128 b)
 {
-	Matrix4 mtx;
-
-	//Add the matrices
-	for (int i = 0; i < 4; i++)
-	{
-		for (int j = 0; j < 4; j++)
-		{
-			mtx.m[i][j] += m[i][j] + rhs.m[i][j];
-		}
-	}
-
-	return mtx;
+	return _mm_add_ps(_mm_mul_ps(a, SWIZZLE(b, 0, 3, 0, 3)), _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
 }
 
 /**
-* @brief  Substraction of 2 matrices
+* @brief  Adjugate of a times b, for 2x2 matrices
 *
-* @param rhs:		matrix to substract
-* @return mtx:		result of the substraction
+* @param a, b:		matrices to multiply
+* @return:			adj(a) * b
 */
-Matrix4 Matrix4::operator-(const Matrix4& rhs) const
+static inline __m128 Mat2AdjMul(__m128 a, __m128 b)
 {
-	Matrix4 mtx;
-
-	//Substract matrices
-	for (int i = 0; i < 4; i++)
-	{
-		for (int j = 0; j < 4; j++)
-		{
-			mtx.m[i][j] += m[i][j] - rhs.m[i][j];
-		}
-	}
-
-	return mtx;
+	return _mm_sub_ps(_mm_mul_ps(SWIZZLE(a, 3, 3, 0, 0), b), _mm_mul_ps(SWIZZLE(a, 1, 1, 2, 2), SWIZZLE(b, 2, 3, 0, 1)));
 }
 
 /**
-* @brief  Multiplication of 2 matrices
+* @brief  a times the adjugate of b, for 2x2 matrices
 *
-* @param rhs:		matrix to multiply
-* @return mtx:		result of the multiplication
+* @param a, b:		matrices to multiply
+* @return:			a * adj(b)
 */
-Matrix4 Matrix4::operator*(const Matrix4& rhs) const
+static inline __m128 Mat2MulAdj(__m128 a, __m128 b)
 {
-	Matrix4 mtx;
-
-	//Multiply the matrices
-	for (int i = 0; i < 4; i++)
-	{
-		for (int j = 0; j < 4; j++)
-		{
-			for (int k = 0; k < 4; k++)
-			{
-				mtx.m[i][j] += m[i][k] * rhs.m[k][j];
-			}
-		}
-	}
-
-	return mtx;
+	return _mm_sub_ps(_mm_mul_ps(a, SWIZZLE(b, 3, 0, 3, 0)), _mm_mul_ps(SWIZZLE(a, 1, 0, 3, 2), SWIZZLE(b, 2, 1, 2, 1)));
 }
 
-/*
-* @brief  Addition of 2 matrices
+/**
+* @brief  Inverse of the matrix with SSE, by blocks: the matrix is split in
+*         four 2x2 matrices A B / C D
 *
-* @param rhs :		matrix to add
-* @return *this:	altered point with result of the addition
+* @param mtx:		matrix to invert
+* @return res:		the inverse, or the zero matrix if the determinant is zero
 */
-Matrix4& Matrix4::operator+=(const Matrix4& rhs)
+Matrix4 Matrix4::InverseSSE(const Matrix4& mtx)
 {
-	//Add matrices
-	*this = *this + rhs;
-	return *this;
+	__m128 r0 = _mm_load_ps(mtx.m[0]);
+	__m128 r1 = _mm_load_ps(mtx.m[1]);
+	__m128 r2 = _mm_load_ps(mtx.m[2]);
+	__m128 r3 = _mm_load_ps(mtx.m[3]);
+
+	//The 2x2 blocks
+	__m128 A = _mm_movelh_ps(r0, r1);
+	__m128 B = _mm_movehl_ps(r1, r0);
+	__m128 C = _mm_movelh_ps(r2, r3);
+	__m128 D = _mm_movehl_ps(r3, r2);
+
+	//Determinants of the blocks, |A| |B| |C| |D|
+	__m128 detSub = _mm_sub_ps(_mm_mul_ps(SHUFFLE(r0, r2, 0, 2, 0, 2), SHUFFLE(r1, r3, 1, 3, 1, 3)),
+	                           _mm_mul_ps(SHUFFLE(r0, r2, 1, 3, 1, 3), SHUFFLE(r1, r3, 0, 2, 0, 2)));
+	__m128 detA = SWIZZLE(detSub, 0, 0, 0, 0);
+	__m128 detB = SWIZZLE(detSub, 1, 1, 1, 1);
+	__m128 detC = SWIZZLE(detSub, 2, 2, 2, 2);
+	__m128 detD = SWIZZLE(detSub, 3, 3, 3, 3);
+
+	//Adjugates of the blocks of the inverse (times the determinant)
+	__m128 D_C = Mat2AdjMul(D, C);
+	__m128 A_B = Mat2AdjMul(A, B);
+	__m128 X_  = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, D_C));
+	__m128 W_  = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, A_B));
+	__m128 Y_  = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, A_B));
+	__m128 Z_  = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, D_C));
+
+	//|M| = |A||D| + |B||C| - tr((A#B)(D#C))
+	__m128 tr = _mm_mul_ps(A_B, SWIZZLE(D_C, 0, 2, 1, 3));
+	tr = _mm_add_ps(tr, _mm_movehl_ps(tr, tr));
+	tr = _mm_add_ss(tr, SWIZZLE(tr, 1, 1, 1, 1));
+	__m128 detM = _mm_sub_ss(_mm_add_ss(_mm_mul_ss(detA, detD), _mm_mul_ss(detB, detC)), tr);
+
+	if (_mm_cvtss_f32(detM) == 0.f)
+		return Matrix4();
+
+	//The signs of the adjugate over the determinant
+	__m128 rDetM = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), SWIZZLE(detM, 0, 0, 0, 0));
+	X_ = _mm_mul_ps(X_, rDetM);
+	Y_ = _mm_mul_ps(Y_, rDetM);
+	Z_ = _mm_mul_ps(Z_, rDetM);
+	W_ = _mm_mul_ps(W_, rDetM);
+
+	//Undo the adjugate shuffle while storing
+	Matrix4 res;
+	_mm_store_ps(res.m[0], SHUFFLE(X_, Y_, 3, 1, 3, 1));
+	_mm_store_ps(res.m[1], SHUFFLE(X_, Y_, 2, 0, 2, 0));
+	_mm_store_ps(res.m[2], SHUFFLE(Z_, W_, 3, 1, 3, 1));
+	_mm_store_ps(res.m[3], SHUFFLE(Z_, W_, 2, 0, 2, 0));
+
+	return res;
 }
 
-/*
-* @brief  Substraction of 2 matrices
+/**
+* @brief  Cross product of the x, y, z of 2 registers, w is 0 if both w are finite
 *
-* @param rhs :		matrix to substract
-* @return *this:	altered point with result of the substraction
+* @param a, b:		vectors to multiply
+* @return:			a x b
 */
-Matrix4& Matrix4::operator-=(const Matrix4& rhs)
+static inline __m128 Cross3(__m128 a, __m128 b)
 {
-	//Substract the matrices
-	*this = *this - rhs;
-	return *this;
+	return _mm_sub_ps(_mm_mul_ps(SWIZZLE(a, 1, 2, 0, 3), SWIZZLE(b, 2, 0, 1, 3)),
+	                  _mm_mul_ps(SWIZZLE(a, 2, 0, 1, 3), SWIZZLE(b, 1, 2, 0, 3)));
 }
 
-/*
-* @brief  Multiplication of 2 matrices
+/**
+* @brief  Cofactor rows of the 3x3 part (the cross products of the other 2 rows),
+*         and the determinant in every lane
 *
-* @param rhs :		matrix to multiply
-* @return *this:	altered point with result of the multiplication
+* @param mtx:		matrix to use
+* @param c:			the 3 cofactor rows, w is 0
+* @param det:		determinant of the 3x3 part
 */
-Matrix4& Matrix4::operator*=(const Matrix4& rhs)
+static inline void Cofactors3x3(const Matrix4& mtx, __m128 c[3], __m128& det)
 {
-	//Multiply the matrices
-	*this = *this * rhs;
-	return *this;
+	const __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	__m128 r0 = _mm_and_ps(_mm_load_ps(mtx.m[0]), xyz);
+	__m128 r1 = _mm_and_ps(_mm_load_ps(mtx.m[1]), xyz);
+	__m128 r2 = _mm_and_ps(_mm_load_ps(mtx.m[2]), xyz);
+
+	c[0] = Cross3(r1, r2);
+	c[1] = Cross3(r2, r0);
+	c[2] = Cross3(r0, r1);
+
+	//r0 . c0
+	__m128 d = _mm_mul_ps(r0, c[0]);
+	d = _mm_add_ps(d, _mm_movehl_ps(d, d));
+	d = _mm_add_ss(d, SWIZZLE(d, 1, 1, 1, 1));
+	det = SWIZZLE(d, 0, 0, 0, 0);
 }
 
-/*
-* @brief  Multiplication by an scalar
+/**
+* @brief  Inverse of an affine matrix with SSE
 *
-* @param rhs :		scalar to multiply
-* @return mtx:		result of the multiplication
+* @param mtx:		matrix to invert, the last row must be 0,0,0,1
+* @return res:		the inverse, or the zero matrix if the determinant is zero
 */
-Matrix4 Matrix4::operator*(const float rhs) const
+Matrix4 Matrix4::AffineInverseSSE(const Matrix4& mtx)
 {
-	//Multiply every value by the scalar
-	Matrix4 mtx;
-	for (int i = 0; i < 16; i++)
-		mtx.v[i] = rhs * v[i];
+	__m128 c[3], det;
+	Cofactors3x3(mtx, c, det);
 
-	return mtx;
+	if (_mm_cvtss_f32(det) == 0.f)
+		return Matrix4();
+
+	//The inverse of the 3x3 part is the transposed cofactors, the translation
+	//column is -(cofactors^T * t), placed in the 4th row before transposing
+	__m128 t = _mm_mul_ps(_mm_set1_ps(mtx.m[0][3]), c[0]);
+	t = _mm_add_ps(t, _mm_mul_ps(_mm_set1_ps(mtx.m[1][3]), c[1]));
+	t = _mm_add_ps(t, _mm_mul_ps(_mm_set1_ps(mtx.m[2][3]), c[2]));
+	t = _mm_sub_ps(_mm_setzero_ps(), t);
+	_MM_TRANSPOSE4_PS(c[0], c[1], c[2], t);
+
+	__m128 invDet = _mm_div_ps(_mm_set1_ps(1.f), det);
+
+	Matrix4 res;
+	_mm_store_ps(res.m[0], _mm_mul_ps(c[0], invDet));
+	_mm_store_ps(res.m[1], _mm_mul_ps(c[1], invDet));
+	_mm_store_ps(res.m[2], _mm_mul_ps(c[2], invDet));
+	res.m[3][3] = 1.f;
+
+	return res;
 }
 
-/*
-* @brief  Division by an scalar
+/**
+* @brief  Inverse transpose of the 3x3 part with SSE
 *
-* @param rhs :		scalar to divide
-* @return mtx:		result of the division
+* @param mtx:		matrix to use
+* @return res:		the matrix for the normals, or the zero matrix if the determinant is zero
 */
-Matrix4 Matrix4::operator/(const float rhs) const
+Matrix4 Matrix4::InverseTranspose3x3SSE(const Matrix4& mtx)
 {
-	//Divide every value by the scalar
-	Matrix4 mtx;
-	for (int i = 0; i < 16; i++)
-		mtx.v[i] = v[i] / rhs;
+	__m128 c[3], det;
+	Cofactors3x3(mtx, c, det);
 
-	return mtx;
+	if (_mm_cvtss_f32(det) == 0.f)
+		return Matrix4();
+
+	//The cofactors over the determinant, w stays 0
+	__m128 invDet = _mm_div_ps(_mm_set1_ps(1.f), det);
+
+	Matrix4 res;
+	_mm_store_ps(res.m[0], _mm_mul_ps(c[0], invDet));
+	_mm_store_ps(res.m[1], _mm_mul_ps(c[1], invDet));
+	_mm_store_ps(res.m[2], _mm_mul_ps(c[2], invDet));
+	res.m[3][3] = 1.f;
+
+	return res;
 }
 
-/*
-* @brief  Multiplication by an scalar
+#undef SHUFFLE
+#undef SWIZZLE
+
+#endif
+
+
+//Results of the plain loops for the fixtures, computed at compile time
+static constexpr Matrix4 checkFixtures[3] = { checkA, checkProj, checkAffine };
+static constexpr Matrix4 checkTransposed[3] = { checkA.Transpose(), checkProj.Transpose(), checkAffine.Transpose() };
+static constexpr Matrix4 checkInverse[3] = { checkA.Inverse(), checkProj.Inverse(), checkAffine.Inverse() };
+static constexpr Matrix4 checkAffineInverse[3] = { checkA.AffineInverse(), checkProj.AffineInverse(), checkAffine.AffineInverse() };
+static constexpr Matrix4 checkNormal[3] = { checkA.InverseTranspose3x3(), checkProj.InverseTranspose3x3(), checkAffine.InverseTranspose3x3() };
+
+/**
+* @brief  Compares the SSE versions with the constexpr ones on the fixtures,
+*         including the singular checkA (the SSE versions must also give the zero matrix)
 *
-* @param rhs :		scalar to multiply
-* @return *this:	altered matrix with result of the multiplication
+* @param (void)
+* @return:			whether every result is within the epsilon of operator==
 */
-Matrix4& Matrix4::operator*=(const float rhs)
+bool Matrix4::SelfTest(void)
 {
-	//Multiply by rhs
-	*this = *this * rhs;
-	return *this;
+	bool passed = true;
+
+#ifdef MATH_SSE
+	static const char* const names[3] = { "singular", "projection", "affine" };
+	static const char* const functions[4] = { "TransposeSSE", "InverseSSE", "AffineInverseSSE", "InverseTranspose3x3SSE" };
+
+	for (int i = 0; i < 3; i++)
+	{
+		const Matrix4& mtx = checkFixtures[i];
+		const Matrix4 results[4] = { TransposeSSE(mtx), InverseSSE(mtx), AffineInverseSSE(mtx), InverseTranspose3x3SSE(mtx) };
+		const Matrix4* expected[4] = { &checkTransposed[i], &checkInverse[i], &checkAffineInverse[i], &checkNormal[i] };
+
+		for (int j = 0; j < 4; j++)
+		{
+			if (results[j] == *expected[j])
+				continue;
+
+			std::printf("Matrix4::%s differs on the %s matrix, expected and got:\n", functions[j], names[i]);
+			expected[j]->Print();
+			results[j].Print();
+			passed = false;
+		}
+	}
+#endif
+
+	return passed;
 }
 
-/*
-* @brief  Division by an scalar
+
+/**
+* @brief  Multiplies count points from the x, y, z, w arrays, one at a time
 *
-* @param rhs :		scalar to divide
-* @return mtx:		altered matrix with result of the division
+* @param mtx:		matrix to multiply by
+* @param in:		arrays of the points to multiply
+* @param out:		arrays for the results (can be the same as in)
+* @param first:		first point to multiply
+* @param count:		number of points, from first
+* @param divide:	whether to do the perspective division
 */
-Matrix4& Matrix4::operator/=(const float rhs)
+static void TransformPointsScalar(const Matrix4& mtx, const Point4SoA& in, Point4SoA& out, size_t first, size_t count, bool divide)
 {
-	//Divide by rhs
-	*this = *this / rhs;
-	return *this;
+	for (size_t i = first; i < first + count; i++)
+	{
+		float p[4] = { in.x[i], in.y[i], in.z[i], in.w[i] };
+		float r[4];
+
+		for (int row = 0; row < 4; row++)
+			r[row] = mtx.m[row][0] * p[0] + mtx.m[row][1] * p[1] + mtx.m[row][2] * p[2] + mtx.m[row][3] * p[3];
+
+		if (divide)
+		{
+			float inv_w = 1.f / r[3];
+			r[0] *= inv_w;
+			r[1] *= inv_w;
+			r[2] *= inv_w;
+			r[3] = 1.f;
+		}
+
+		out.x[i] = r[0];
+		out.y[i] = r[1];
+		out.z[i] = r[2];
+		out.w[i] = r[3];
+	}
 }
 
+#ifdef MATH_SSE
+
 /**
-* @brief Comparison operator, should use funciton from MathUtilities.h
+* @brief  Multiplies the points 4 at a time, every SSE register holds one coordinate
 *
-* @param rhs:			matrix to compare
-* @return true/false:	whether the matrices are equal
+* @param mtx:		matrix to multiply by
+* @param in:		arrays of the points to multiply
+* @param out:		arrays for the results (can be the same as in)
+* @param divide:	whether to do the perspective division
 */
-bool Matrix4::operator==(const Matrix4& rhs) const
+static void TransformPointsSSE(const Matrix4& mtx, const Point4SoA& in, Point4SoA& out, bool divide)
 {
-	//Compare values in the matrix using macro function
-	for (int i = 0; i < 16; i++)
+	size_t count = in.Size();
+	size_t i     = 0;
+
+	for (; i + 4 <= count; i += 4)
 	{
-		if (!isEqual(v[i], rhs.v[i]))
-			return false;
+		__m128 p[4] = { _mm_loadu_ps(&in.x[i]), _mm_loadu_ps(&in.y[i]), _mm_loadu_ps(&in.z[i]), _mm_loadu_ps(&in.w[i]) };
+		__m128 r[4];
+
+		for (int row = 0; row < 4; row++)
+		{
+			r[row] = _mm_mul_ps(_mm_set1_ps(mtx.m[row][0]), p[0]);
+			r[row] = _mm_add_ps(r[row], _mm_mul_ps(_mm_set1_ps(mtx.m[row][1]), p[1]));
+			r[row] = _mm_add_ps(r[row], _mm_mul_ps(_mm_set1_ps(mtx.m[row][2]), p[2]));
+			r[row] = _mm_add_ps(r[row], _mm_mul_ps(_mm_set1_ps(mtx.m[row][3]), p[3]));
+		}
+
+		if (divide)
+		{
+			__m128 inv_w = _mm_div_ps(_mm_set1_ps(1.f), r[3]);
+			r[0] = _mm_mul_ps(r[0], inv_w);
+			r[1] = _mm_mul_ps(r[1], inv_w);
+			r[2] = _mm_mul_ps(r[2], inv_w);
+			r[3] = _mm_set1_ps(1.f);
+		}
+
+		_mm_storeu_ps(&out.x[i], r[0]);
+		_mm_storeu_ps(&out.y[i], r[1]);
+		_mm_storeu_ps(&out.z[i], r[2]);
+		_mm_storeu_ps(&out.w[i], r[3]);
 	}
 
-	return true;
+	//Remaining points
+	TransformPointsScalar(mtx, in, out, i, count - i, divide);
 }
 
+#ifdef MATH_AVX2
 
 /**
-* @brief Comparison operator
+* @brief  Multiplies the points 8 at a time, every AVX register holds one coordinate
 *
-* @param rhs:			marix to compare
-* @return true/false:	whether the matrices are different
+* @param mtx:		matrix to multiply by
+* @param in:		arrays of the points to multiply
+* @param out:		arrays for the results (can be the same as in)
+* @param divide:	whether to do the perspective division
 */
-bool Matrix4::operator!=(const Matrix4& rhs) const
+TARGET_AVX2 static void TransformPointsAVX2(const Matrix4& mtx, const Point4SoA& in, Point4SoA& out, bool divide)
 {
-	//Compare matrices
-	return !(*this == rhs);
-}
+	size_t count = in.Size();
+	size_t i     = 0;
 
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256 p[4] = { _mm256_loadu_ps(&in.x[i]), _mm256_loadu_ps(&in.y[i]), _mm256_loadu_ps(&in.z[i]), _mm256_loadu_ps(&in.w[i]) };
+		__m256 r[4];
 
+		for (int row = 0; row < 4; row++)
+		{
+			r[row] = _mm256_mul_ps(_mm256_set1_ps(mtx.m[row][0]), p[0]);
+			r[row] = _mm256_add_ps(r[row], _mm256_mul_ps(_mm256_set1_ps(mtx.m[row][1]), p[1]));
+			r[row] = _mm256_add_ps(r[row], _mm256_mul_ps(_mm256_set1_ps(mtx.m[row][2]), p[2]));
+			r[row] = _mm256_add_ps(r[row], _mm256_mul_ps(_mm256_set1_ps(mtx.m[row][3]), p[3]));
+		}
 
-/**
-* @brief  Sets all values of the matrix to zero
-*
-* @param (void)
-*/
-void Matrix4::Zero(void)
-{
-	//Set everything to 0
-	for (int i = 0; i < 16; i++)
-		v[i] = 0.0f;
+		if (divide)
+		{
+			__m256 inv_w = _mm256_div_ps(_mm256_set1_ps(1.f), r[3]);
+			r[0] = _mm256_mul_ps(r[0], inv_w);
+			r[1] = _mm256_mul_ps(r[1], inv_w);
+			r[2] = _mm256_mul_ps(r[2], inv_w);
+			r[3] = _mm256_set1_ps(1.f);
+		}
+
+		_mm256_storeu_ps(&out.x[i], r[0]);
+		_mm256_storeu_ps(&out.y[i], r[1]);
+		_mm256_storeu_ps(&out.z[i], r[2]);
+		_mm256_storeu_ps(&out.w[i], r[3]);
+	}
+
+	//Remaining points
+	TransformPointsScalar(mtx, in, out, i, count - i, divide);
 }
 
+#endif
+
+#endif
+
 /**
-* @brief  Builds the identity matrix
+* @brief  Multiplies every point of an array (structure of arrays) by the matrix
 *
-* @param (void)
+* @param in:		points to multiply
+* @param out:		result of the multiplications, can be the same as in
+* @param divide:	whether to divide x, y and z by w (perspective division)
 */
-void Matrix4::Identity(void)
+void Matrix4::TransformPoints(const Point4SoA& in, Point4SoA& out, bool divide) const
 {
-	//Make a zero matrix and set the main diagonal to 1
-	Zero();
-	for (int i = 0; i < 4; i++)
-		m[i][i] = 1.0f;
-}
\ No newline at end of file
+	out.Resize(in.Size());
+
+#ifdef MATH_SSE
+#ifdef MATH_AVX2
+	//Widest version the CPU supports, checked only once
+	static const bool avx2 = CpuHasAVX2();
+
+	if (avx2)
+	{
+		TransformPointsAVX2(*this, in, out, divide);
+		return;
+	}
+#endif
+
+	TransformPointsSSE(*this, in, out, divide);
+#else
+	TransformPointsScalar(*this, in, out, 0, in.Size(), divide);
+#endif
+}
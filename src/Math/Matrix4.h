@@ -4,8 +4,10 @@
 #include <cstdio>              // printf
 #include "Vector4.h"
 #include "Point4.h"
+#include "Point4SoA.h"
+#include "MathUtilities.h"
 
-class Matrix4
+class alignas(16) Matrix4
 {
     public:
         
@@ -23,52 +25,79 @@ class Matrix4
         */
 
         // Default constructor should initialize to zeroes
-        Matrix4(void);
-
-        // Copy constructor, copies every entry from the other matrix.
-        Matrix4(const Matrix4& rhs);
+        constexpr Matrix4(void) : m{} {}
 
         // Non-default constructor, self-explanatory
-        Matrix4(float mm00, float mm01, float mm02, float mm03,
+        constexpr Matrix4(float mm00, float mm01, float mm02, float mm03,
         float mm10, float mm11, float mm12, float mm13,
         float mm20, float mm21, float mm22, float mm23,
-        float mm30, float mm31, float mm32, float mm33);
+        float mm30, float mm31, float mm32, float mm33)
+            : m{{mm00, mm01, mm02, mm03},
+                {mm10, mm11, mm12, mm13},
+                {mm20, mm21, mm22, mm23},
+                {mm30, mm31, mm32, mm33}} {}
 
-        // Assignment operator, does not need to handle self-assignment
-        Matrix4& operator=(const Matrix4& rhs);
+        // Copy and move are plain memberwise copies (no comparison first),
+        // so the class is trivially copyable
+        Matrix4(const Matrix4& rhs) = default;
+        Matrix4(Matrix4&& rhs) = default;
+        Matrix4& operator=(const Matrix4& rhs) = default;
+        Matrix4& operator=(Matrix4&& rhs) = default;
 
         // Multiplying a Matrix4 with a Vector4 or a Point4
-        Vector4 operator*(const Vector4& rhs) const;
-        Point4 operator*(const Point4& rhs) const;
+        constexpr Vector4 operator*(const Vector4& rhs) const;
+        constexpr Point4 operator*(const Point4& rhs) const;
+
+        // Multiplies every point of in and stores them in out (which can be in).
+        // If divide is true x, y and z are also divided by w, and w becomes 1.
+        void TransformPoints(const Point4SoA& in, Point4SoA& out, bool divide = false) const;
 
         // Basic Matrix arithmetic operations
-        Matrix4 operator+(const Matrix4& rhs) const;
-        Matrix4 operator-(const Matrix4& rhs) const;
-        Matrix4 operator*(const Matrix4& rhs) const;
+        constexpr Matrix4 operator+(const Matrix4& rhs) const;
+        constexpr Matrix4 operator-(const Matrix4& rhs) const;
+        constexpr Matrix4 operator*(const Matrix4& rhs) const;
 
         // Similar to the three above except they modify the original
-        Matrix4& operator+=(const Matrix4& rhs);
-        Matrix4& operator-=(const Matrix4& rhs);
-        Matrix4& operator*=(const Matrix4& rhs);
+        constexpr Matrix4& operator+=(const Matrix4& rhs);
+        constexpr Matrix4& operator-=(const Matrix4& rhs);
+        constexpr Matrix4& operator*=(const Matrix4& rhs);
 
         // Scale/Divide the entire matrix by a float
-        Matrix4 operator*(const float rhs) const;
-        Matrix4 operator/(const float rhs) const;
+        constexpr Matrix4 operator*(const float rhs) const;
+        constexpr Matrix4 operator/(const float rhs) const;
         // Same as previous
-        Matrix4& operator*=(const float rhs);
-        Matrix4& operator/=(const float rhs);
+        constexpr Matrix4& operator*=(const float rhs);
+        constexpr Matrix4& operator/=(const float rhs);
 
         // Comparison operators which should use an epsilon defined in
         // MathUtilities.h to see if the value is within a certain range
         // in which case we say they are equivalent.
-        bool operator==(const Matrix4& rhs) const;
-        bool operator!=(const Matrix4& rhs) const;
+        constexpr bool operator==(const Matrix4& rhs) const;
+        constexpr bool operator!=(const Matrix4& rhs) const;
+
+        // Transposed copy of the matrix
+        constexpr Matrix4 Transpose(void) const;
+        // Inverse of any matrix, the zero matrix if it can't be inverted
+        constexpr Matrix4 Inverse(void) const;
+        // Inverse of a matrix whose last row is 0,0,0,1 (faster), the zero matrix if it
+        // can't be inverted
+        constexpr Matrix4 AffineInverse(void) const;
+        // Inverse transpose of the upper 3x3 part (the matrix for the normals), the rest
+        // is identity. The zero matrix if it can't be inverted
+        constexpr Matrix4 InverseTranspose3x3(void) const;
 
         // Zeroes out the entire matrix
-        void Zero(void);
+        constexpr void Zero(void);
 
         // Builds the identity matrix
-        void Identity(void);
+        constexpr void Identity(void);
+        // Returns an identity matrix, can be used to build constants at compile time
+        static constexpr Matrix4 IdentityMatrix(void);
+
+        // Runs the SSE versions of Transpose, Inverse, AffineInverse and InverseTranspose3x3
+        // on known matrices and compares them with the constexpr results. Prints every
+        // mismatch and returns false if there is any (always true without SSE)
+        static bool SelfTest(void);
 
         // Already implemented, simple print function
         void Print(void) const
@@ -80,6 +109,471 @@ class Matrix4
             std::printf("%5.3f %5.3f %5.3f %5.3f\n", m[3][0], m[3][1], m[3][2], m[3][3]);
             std::printf("--------------------------\n");
         }
+
+    private:
+
+#ifdef MATH_SSE
+        // SSE versions of the multiplications, only used outside of constant expressions
+        static void MultiplySSE(const Matrix4& mtx, const float* in, float* out);
+        static Matrix4 ConcatenateSSE(const Matrix4& lhs, const Matrix4& rhs);
+        static Matrix4 TransposeSSE(const Matrix4& mtx);
+        static Matrix4 InverseSSE(const Matrix4& mtx);
+        static Matrix4 AffineInverseSSE(const Matrix4& mtx);
+        static Matrix4 InverseTranspose3x3SSE(const Matrix4& mtx);
+#endif
 };
 
+/*
+    Everything but TransformPoints is constexpr, so it is defined here. Constant
+    expressions can only read the array that was initialized (m), never v
+*/
+
+/**
+* @brief  Multiplying a Matrix4 with a Vector4
+*
+* @param rhs:       vector to multiply
+* @return vec:      result of the multiplication
+*/
+constexpr Vector4 Matrix4::operator*(const Vector4& rhs) const
+{
+    Vector4 vec;
+
+#ifdef MATH_SSE
+    if (!MATH_CONSTANT_EVALUATED())
+    {
+        MultiplySSE(*this, rhs.v, vec.v);
+        return vec;
+    }
+#endif
+
+    //Do the multiplication
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            vec.v[i] += m[i][j] * rhs.v[j];
+        }
+    }
+
+    return vec;
+}
+
+/**
+* @brief  Multiplying a Matrix4 with a Point4
+*
+* @param rhs:       point to multiply
+* @return point:    result of the multiplication
+*/
+constexpr Point4 Matrix4::operator*(const Point4& rhs) const
+{
+    Point4 point;
+
+#ifdef MATH_SSE
+    if (!MATH_CONSTANT_EVALUATED())
+    {
+        MultiplySSE(*this, rhs.v, point.v);
+        return point;
+    }
+#endif
+
+    //Do the multiplication
+    point.v[3] = 0.f;
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            point.v[i] += m[i][j] * rhs.v[j];
+        }
+    }
+
+    return point;
+}
+
+/**
+* @brief  Addition of 2 matrices
+*
+* @param rhs:       matrix to add
+* @return mtx:      result of the addition
+*/
+constexpr Matrix4 Matrix4::operator+(const Matrix4& rhs) const
+{
+    Matrix4 mtx;
+
+    //Add the matrices
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            mtx.m[i][j] += m[i][j] + rhs.m[i][j];
+        }
+    }
+
+    return mtx;
+}
+
+/**
+* @brief  Substraction of 2 matrices
+*
+* @param rhs:       matrix to substract
+* @return mtx:      result of the substraction
+*/
+constexpr Matrix4 Matrix4::operator-(const Matrix4& rhs) const
+{
+    Matrix4 mtx;
+
+    //Substract matrices
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            mtx.m[i][j] += m[i][j] - rhs.m[i][j];
+        }
+    }
+
+    return mtx;
+}
+
+/**
+* @brief  Multiplication of 2 matrices
+*
+* @param rhs:       matrix to multiply
+* @return mtx:      result of the multiplication
+*/
+constexpr Matrix4 Matrix4::operator*(const Matrix4& rhs) const
+{
+#ifdef MATH_SSE
+    if (!MATH_CONSTANT_EVALUATED())
+        return ConcatenateSSE(*this, rhs);
+#endif
+
+    //Multiply the matrices
+    Matrix4 mtx;
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                mtx.m[i][j] += m[i][k] * rhs.m[k][j];
+            }
+        }
+    }
+
+    return mtx;
+}
+
+/*
+* @brief  Addition of 2 matrices
+*
+* @param rhs :      matrix to add
+* @return *this:    altered point with result of the addition
+*/
+constexpr Matrix4& Matrix4::operator+=(const Matrix4& rhs)
+{
+    //Add matrices
+    *this = *this + rhs;
+    return *this;
+}
+
+/*
+* @brief  Substraction of 2 matrices
+*
+* @param rhs :      matrix to substract
+* @return *this:    altered point with result of the substraction
+*/
+constexpr Matrix4& Matrix4::operator-=(const Matrix4& rhs)
+{
+    //Substract the matrices
+    *this = *this - rhs;
+    return *this;
+}
+
+/*
+* @brief  Multiplication of 2 matrices
+*
+* @param rhs :      matrix to multiply
+* @return *this:    altered point with result of the multiplication
+*/
+constexpr Matrix4& Matrix4::operator*=(const Matrix4& rhs)
+{
+    //Multiply the matrices
+    *this = *this * rhs;
+    return *this;
+}
+
+/*
+* @brief  Multiplication by an scalar
+*
+* @param rhs :      scalar to multiply
+* @return mtx:      result of the multiplication
+*/
+constexpr Matrix4 Matrix4::operator*(const float rhs) const
+{
+    //Multiply every value by the scalar
+    Matrix4 mtx;
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            mtx.m[i][j] = rhs * m[i][j];
+
+    return mtx;
+}
+
+/*
+* @brief  Division by an scalar
+*
+* @param rhs :      scalar to divide
+* @return mtx:      result of the division
+*/
+constexpr Matrix4 Matrix4::operator/(const float rhs) const
+{
+    //Divide every value by the scalar
+    Matrix4 mtx;
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            mtx.m[i][j] = m[i][j] / rhs;
+
+    return mtx;
+}
+
+/*
+* @brief  Multiplication by an scalar
+*
+* @param rhs :      scalar to multiply
+* @return *this:    altered matrix with result of the multiplication
+*/
+constexpr Matrix4& Matrix4::operator*=(const float rhs)
+{
+    //Multiply by rhs
+    *this = *this * rhs;
+    return *this;
+}
+
+/*
+* @brief  Division by an scalar
+*
+* @param rhs :      scalar to divide
+* @return mtx:      altered matrix with result of the division
+*/
+constexpr Matrix4& Matrix4::operator/=(const float rhs)
+{
+    //Divide by rhs
+    *this = *this / rhs;
+    return *this;
+}
+
+/**
+* @brief Comparison operator, should use funciton from MathUtilities.h
+*
+* @param rhs:           matrix to compare
+* @return true/false:   whether the matrices are equal
+*/
+constexpr bool Matrix4::operator==(const Matrix4& rhs) const
+{
+    //Compare values in the matrix using macro function
+    for (int i = 0; i < 4; i++)
+    {
+        for (int j = 0; j < 4; j++)
+        {
+            if (!isEqual(m[i][j], rhs.m[i][j]))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+* @brief Comparison operator
+*
+* @param rhs:           marix to compare
+* @return true/false:   whether the matrices are different
+*/
+constexpr bool Matrix4::operator!=(const Matrix4& rhs) const
+{
+    //Compare matrices
+    return !(*this == rhs);
+}
+
+/**
+* @brief  Transposed copy of the matrix
+*
+* @param (void)
+* @return mtx:      rows and columns swapped
+*/
+constexpr Matrix4 Matrix4::Transpose(void) const
+{
+#ifdef MATH_SSE
+    if (!MATH_CONSTANT_EVALUATED())
+        return TransposeSSE(*this);
+#endif
+
+    Matrix4 mtx;
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            mtx.m[i][j] = m[j][i];
+
+    return mtx;
+}
+
+/**
+* @brief  Inverse of the matrix, from the 2x2 determinants of the top 2 and the bottom 2 rows
+*
+* @param (void)
+* @return inv:      the inverse, or the zero matrix if the determinant is zero
+*/
+constexpr Matrix4 Matrix4::Inverse(void) const
+{
+#ifdef MATH_SSE
+    if (!MATH_CONSTANT_EVALUATED())
+        return InverseSSE(*this);
+#endif
+
+    //2x2 determinants of the first 2 rows
+    float s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+    float s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+    float s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+    float s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+    float s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+    float s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+
+    //2x2 determinants of the last 2 rows
+    float c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+    float c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+    float c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+    float c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+    float c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+    float c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+
+    float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    if (det == 0.f)
+        return Matrix4();
+
+    float invDet = 1.f / det;
+
+    //Adjugate over the determinant
+    return Matrix4(( m[1][1] * c5 - m[1][2] * c4 + m[1][3] * c3) * invDet,
+                   (-m[0][1] * c5 + m[0][2] * c4 - m[0][3] * c3) * invDet,
+                   ( m[3][1] * s5 - m[3][2] * s4 + m[3][3] * s3) * invDet,
+                   (-m[2][1] * s5 + m[2][2] * s4 - m[2][3] * s3) * invDet,
+
+                   (-m[1][0] * c5 + m[1][2] * c2 - m[1][3] * c1) * invDet,
+                   ( m[0][0] * c5 - m[0][2] * c2 + m[0][3] * c1) * invDet,
+                   (-m[3][0] * s5 + m[3][2] * s2 - m[3][3] * s1) * invDet,
+                   ( m[2][0] * s5 - m[2][2] * s2 + m[2][3] * s1) * invDet,
+
+                   ( m[1][0] * c4 - m[1][1] * c2 + m[1][3] * c0) * invDet,
+                   (-m[0][0] * c4 + m[0][1] * c2 - m[0][3] * c0) * invDet,
+                   ( m[3][0] * s4 - m[3][1] * s2 + m[3][3] * s0) * invDet,
+                   (-m[2][0] * s4 + m[2][1] * s2 - m[2][3] * s0) * invDet,
+
+                   (-m[1][0] * c3 + m[1][1] * c1 - m[1][2] * c0) * invDet,
+                   ( m[0][0] * c3 - m[0][1] * c1 + m[0][2] * c0) * invDet,
+                   (-m[3][0] * s3 + m[3][1] * s1 - m[3][2] * s0) * invDet,
+                   ( m[2][0] * s3 - m[2][1] * s1 + m[2][2] * s0) * invDet);
+}
+
+/**
+* @brief  Inverse of an affine matrix: the inverse of the 3x3 part, and the
+*         translation moved back by it
+*
+* @param (void)
+* @return inv:      the inverse, or the zero matrix if the determinant is zero
+*/
+constexpr Matrix4 Matrix4::AffineInverse(void) const
+{
+#ifdef MATH_SSE
+    if (!MATH_CONSTANT_EVALUATED())
+        return AffineInverseSSE(*this);
+#endif
+
+    //The inverse transpose of the 3x3 part, transposed back
+    Matrix4 inv = InverseTranspose3x3();
+    if (inv.m[3][3] == 0.f)
+        return inv;
+
+    inv = inv.Transpose();
+
+    //Undo the translation in the inverted frame
+    for (int i = 0; i < 3; i++)
+        inv.m[i][3] = -(inv.m[i][0] * m[0][3] + inv.m[i][1] * m[1][3] + inv.m[i][2] * m[2][3]);
+
+    return inv;
+}
+
+/**
+* @brief  Inverse transpose of the 3x3 part, its rows are the cross products of
+*         the other 2 rows over the determinant
+*
+* @param (void)
+* @return inv:      the matrix for the normals, or the zero matrix if the determinant is zero
+*/
+constexpr Matrix4 Matrix4::InverseTranspose3x3(void) const
+{
+#ifdef MATH_SSE
+    if (!MATH_CONSTANT_EVALUATED())
+        return InverseTranspose3x3SSE(*this);
+#endif
+
+    //Cofactor matrix
+    float c[3][3] = {};
+    for (int i = 0; i < 3; i++)
+    {
+        int a = (i + 1) % 3;
+        int b = (i + 2) % 3;
+        c[i][0] = m[a][1] * m[b][2] - m[a][2] * m[b][1];
+        c[i][1] = m[a][2] * m[b][0] - m[a][0] * m[b][2];
+        c[i][2] = m[a][0] * m[b][1] - m[a][1] * m[b][0];
+    }
+
+    float det = m[0][0] * c[0][0] + m[0][1] * c[0][1] + m[0][2] * c[0][2];
+    if (det == 0.f)
+        return Matrix4();
+
+    float invDet = 1.f / det;
+    return Matrix4(c[0][0] * invDet, c[0][1] * invDet, c[0][2] * invDet, 0.f,
+                   c[1][0] * invDet, c[1][1] * invDet, c[1][2] * invDet, 0.f,
+                   c[2][0] * invDet, c[2][1] * invDet, c[2][2] * invDet, 0.f,
+                   0.f,              0.f,              0.f,              1.f);
+}
+
+/**
+* @brief  Sets all values of the matrix to zero
+*
+* @param (void)
+*/
+constexpr void Matrix4::Zero(void)
+{
+    //Set everything to 0
+    for (int i = 0; i < 4; i++)
+        for (int j = 0; j < 4; j++)
+            m[i][j] = 0.0f;
+}
+
+/**
+* @brief  Builds the identity matrix
+*
+* @param (void)
+*/
+constexpr void Matrix4::Identity(void)
+{
+    //Make a zero matrix and set the main diagonal to 1
+    Zero();
+    for (int i = 0; i < 4; i++)
+        m[i][i] = 1.0f;
+}
+
+/**
+* @brief  Returns an identity matrix
+*
+* @param (void)
+* @return mtx:      the identity matrix
+*/
+constexpr Matrix4 Matrix4::IdentityMatrix(void)
+{
+    return Matrix4(1.0f, 0.0f, 0.0f, 0.0f,
+                   0.0f, 1.0f, 0.0f, 0.0f,
+                   0.0f, 0.0f, 1.0f, 0.0f,
+                   0.0f, 0.0f, 0.0f, 1.0f);
+}
+
 #endif
\ No newline at end of file
@@ -3,8 +3,9 @@
 
 #include <cstdio>              // printf
 #include "Vector4.h"
+#include "MathUtilities.h"
 
-class Point4
+class alignas(16) Point4
 {
     public:
 
@@ -30,35 +31,36 @@ class Point4
         */
 
         // Default constructor, sets x,y,z to zero and w to the defined value
-        Point4(void);
-        // Copy constructor, copies every component from the other Point4
-        Point4(const Point4& rhs);
+        constexpr Point4(void) : v{0.0f, 0.0f, 0.0f, 1.0f} {}
         // Non-Default constructor, self-explanatory
-        Point4(float xx, float yy, float zz, float ww = 1.0f);
+        constexpr Point4(float xx, float yy, float zz, float ww = 1.0f) : v{xx, yy, zz, ww} {}
 
-        // Assignment operator, copies every component from the other Point4
-        Point4& operator=(const Point4& rhs);
+        // Copy and move are plain memberwise copies, so the class is trivially copyable
+        Point4(const Point4& rhs) = default;
+        Point4(Point4&& rhs) = default;
+        Point4& operator=(const Point4& rhs) = default;
+        Point4& operator=(Point4&& rhs) = default;
         // Unary negation operator, negates every component and returns a copy
-        Point4 operator-(void) const;
+        constexpr Point4 operator-(void) const;
         // Binary subtraction operator, Subtract two Point4s and you get a Vector4
-        Vector4 operator-(const Point4& rhs) const;
+        constexpr Vector4 operator-(const Point4& rhs) const;
         // Basic vector math operations with points, you can add a Vector4 to a Point4, or
         // subtract a Vector4 from a Point4
-        Point4 operator+ (const Vector4& rhs) const;
-        Point4 operator- (const Vector4& rhs) const;
+        constexpr Point4 operator+ (const Vector4& rhs) const;
+        constexpr Point4 operator- (const Vector4& rhs) const;
         // Same as previous two operators, just modifies the original instead of returning a
         // copy
-        Point4& operator+=(const Vector4& rhs);
-        Point4& operator-=(const Vector4& rhs);
+        constexpr Point4& operator+=(const Vector4& rhs);
+        constexpr Point4& operator-=(const Vector4& rhs);
 
         // Comparison operators which should use an epsilon defined in
         // MathUtilities.h to see if the value is within a certain range
         // in which case we say they are equivalent.
-        bool operator==(const Point4& rhs) const;
-        bool operator!=(const Point4& rhs) const;
+        constexpr bool operator==(const Point4& rhs) const;
+        constexpr bool operator!=(const Point4& rhs) const;
 
         // Sets x,y,z to zeroes, w to defined value
-        void Zero(void);
+        constexpr void Zero(void);
 
         // Already implemented, simple print function
         void Print(void) const
@@ -67,4 +69,138 @@ class Point4
         }
 };
 
+/*
+    Everything is constexpr, so it is defined here. Constant expressions can only
+    read the array that was initialized (v), never x,y,z,w or r,g,b,a
+*/
+
+/**
+* @brief Unary negation operator, negates all components and returns a copy
+*
+* @param rhs:       point to copy from
+* @return vec:      point with negated values
+*/
+constexpr Point4 Point4::operator-(void) const
+{
+    //Make new point with negated values
+    Point4 point;
+    for (int i = 0; i < 4; i++)
+        point.v[i] = -v[i];
+
+    return point;
+}
+
+/**
+* @brief Binary subtraction operator, Subtract two Point4s and you get a Vector4
+*
+* @param rhs:       point to substract
+* @return vec:      result of the substraction
+*/
+constexpr Vector4 Point4::operator-(const Point4& rhs) const
+{
+    //Substract the points
+    Vector4 vec;
+    for (int i = 0; i < 4; i++)
+        vec.v[i] = v[i] - rhs.v[i];
+
+    return vec;
+}
+
+/**
+* @brief Addition of point and vector
+*
+* @param rhs:       vector to add
+* @return point:    result of the addition
+*/
+constexpr Point4 Point4::operator+ (const Vector4& rhs) const
+{
+    //Add values
+    Point4 point;
+    for (int i = 0; i < 4; i++)
+        point.v[i] = v[i] + rhs.v[i];
+
+    return point;
+}
+
+/**
+* @brief substractions of point and vector
+*
+* @param rhs:       vector to substract
+* @return point:    result of the substraction
+*/
+constexpr Point4 Point4::operator- (const Vector4& rhs) const
+{
+    //Substract values
+    Point4 point;
+    for (int i = 0; i < 4; i++)
+        point.v[i] = v[i] - rhs.v[i];
+
+    return point;
+}
+
+/**
+* @brief Addition of point and vector
+*
+* @param rhs:       vector to add
+* @return *this:    altered point with result of the addition
+*/
+constexpr Point4& Point4::operator+=(const Vector4& rhs)
+{
+    //Add the values
+    *this = *this + rhs;
+    return *this;
+}
+
+/**
+* @brief substractions of point and vector
+*
+* @param rhs:       vector to substract
+* @return *this:    altered point with result of the substraction
+*/
+constexpr Point4& Point4::operator-=(const Vector4& rhs)
+{
+    //Substract the values
+    *this = *this - rhs;
+    return *this;
+}
+
+/**
+* @brief Comparison operator, should use funciton from MathUtilities.h
+*
+* @param rhs:           point to compare
+* @return true/false:   whether the points are equal
+*/
+constexpr bool Point4::operator==(const Point4& rhs) const
+{
+    //Compare points using macro function
+    for (int i = 0; i < 4; i++)
+        if (!isEqual(v[i], rhs.v[i]))
+            return false;
+
+    return true;
+}
+
+/**
+* @brief Comparison operator
+*
+* @param rhs:           point to compare
+* @return true/false:   whether the points are different
+*/
+constexpr bool Point4::operator!=(const Point4& rhs) const
+{
+    //Compare points
+    return !(*this == rhs);
+}
+
+/**
+* @brief  Sets x,y,z to zeroes, w to defined value
+*
+* @param (void)
+*/
+constexpr void Point4::Zero(void)
+{
+    //Set the point
+    *this = Point4(0.0f, 0.0f, 0.0f);
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef POINT4SOA_H
+#define POINT4SOA_H
+
+#include <vector>
+#include "Point4.h"
+
+// Array of points stored as one array per coordinate (structure of arrays), so that
+// Matrix4::TransformPoints can work on several points per SIMD instruction
+struct Point4SoA
+{
+    std::vector<float> x, y, z, w;
+
+    // Number of points
+    size_t Size(void) const { return x.size(); }
+
+    // Changes the number of points, new ones are (0, 0, 0, 1)
+    void Resize(size_t count)
+    {
+        x.resize(count, 0.f);
+        y.resize(count, 0.f);
+        z.resize(count, 0.f);
+        w.resize(count, 1.f);
+    }
+
+    // Copies a point in or out of the arrays
+    void Set(size_t i, const Point4& p)
+    {
+        x[i] = p.x;
+        y[i] = p.y;
+        z[i] = p.z;
+        w[i] = p.w;
+    }
+    Point4 Get(size_t i) const
+    {
+        return Point4(x[i], y[i], z[i], w[i]);
+    }
+};
+
+#endif
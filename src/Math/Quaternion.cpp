@@ -0,0 +1,87 @@
+#include "Quaternion.h"			//Header file
+#include "MathUtilities.h"		//Helper macros
+
+#include <cmath>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<Quaternion>::value, "Quaternion must be trivially copyable");
+
+//Compile-time checks, the constexpr functions must give the expected results
+static constexpr Quaternion checkHalfZ(0.f, 0.f, SquareRoot(0.5f), SquareRoot(0.5f));
+
+static_assert(checkHalfZ * checkHalfZ == Quaternion(0.f, 0.f, 1.f, 0.f), "Quaternion product adds the angles");
+static_assert(checkHalfZ * checkHalfZ.Conjugate() == Quaternion(), "Quaternion conjugate is the inverse");
+static_assert(Quaternion(0.f, 0.f, 1.f, 0.f).Rotate(Vector4(1.f, 2.f, 3.f)) == Vector4(-1.f, -2.f, 3.f), "Quaternion rotation");
+static_assert(Quaternion(1.f, 0.f, 0.f, 0.f).ToAffine4() == Affine4(1.f, 0.f, 0.f, 0.f, 0.f, -1.f, 0.f, 0.f, 0.f, 0.f, -1.f, 0.f), "Quaternion matrix");
+static_assert(Quaternion().ToMatrix4() == Matrix4::IdentityMatrix(), "Quaternion identity");
+static_assert(Quaternion(0.f, 3.f, 0.f, 4.f).Length() == 5.f, "Quaternion length");
+
+
+/**
+* @brief  Rotation around an axis
+*
+* @param axis:		axis of the rotation, length 1
+* @param angle:		angle in radians
+* @return quat:		the rotation
+*/
+Quaternion Quaternion::FromAxisAngle(const Vector4& axis, float angle)
+{
+	float s = std::sin(angle * 0.5f);
+	return Quaternion(axis.x * s, axis.y * s, axis.z * s, std::cos(angle * 0.5f));
+}
+
+/**
+* @brief  Same rotation as RotZ * RotY * RotX
+*
+* @param angles:	angles around x, y and z in radians
+* @return quat:		the rotation
+*/
+Quaternion Quaternion::FromEuler(const Vector4& angles)
+{
+	//Sines and cosines of the 3 half angles at once
+	float half[4] = { angles.x * 0.5f, angles.y * 0.5f, angles.z * 0.5f, 0.f };
+	float s[4], c[4];
+	SinCos4(half, s, c);
+
+	//qz * qy * qx expanded
+	return Quaternion(s[0] * c[1] * c[2] - c[0] * s[1] * s[2],
+	                  c[0] * s[1] * c[2] + s[0] * c[1] * s[2],
+	                  c[0] * c[1] * s[2] - s[0] * s[1] * c[2],
+	                  c[0] * c[1] * c[2] + s[0] * s[1] * s[2]);
+}
+
+/**
+* @brief  Spherical interpolation along the shortest arc
+*
+* @param a:			rotation at t = 0
+* @param b:			rotation at t = 1
+* @param t:			interpolation factor
+* @return quat:		the interpolated rotation, length 1
+*/
+Quaternion Quaternion::Slerp(const Quaternion& a, const Quaternion& b, float t)
+{
+	//q and -q are the same rotation, take the one closer to a
+	Quaternion end = b;
+	float cosAngle = a.Dot(b);
+	if (cosAngle < 0.f)
+	{
+		end = Quaternion(-b.x, -b.y, -b.z, -b.w);
+		cosAngle = -cosAngle;
+	}
+
+	//Almost the same rotation: sin(angle) is too small to divide by, interpolate linearly
+	float wa = 1.f - t;
+	float wb = t;
+	if (cosAngle < 0.9995f)
+	{
+		float angle    = std::acos(cosAngle);
+		float invSin   = 1.f / std::sin(angle);
+		wa = std::sin(wa * angle) * invSin;
+		wb = std::sin(wb * angle) * invSin;
+	}
+
+	Quaternion quat(wa * a.x + wb * end.x, wa * a.y + wb * end.y, wa * a.z + wb * end.z, wa * a.w + wb * end.w);
+	quat.Normalize();
+
+	return quat;
+}
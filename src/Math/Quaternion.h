@@ -0,0 +1,230 @@
+#ifndef QUATERNION_H
+#define QUATERNION_H
+
+#include <cstdio>              // printf
+#include "Vector4.h"
+#include "Affine4.h"
+#include "MathUtilities.h"
+
+// Rotation stored as a unit quaternion, x,y,z is the vector part and w the scalar part
+class alignas(16) Quaternion
+{
+    public:
+
+        union
+        {
+            float v[4];
+            struct
+            {
+                float x,y,z,w;
+            };
+        };
+
+        // Default constructor, the identity rotation
+        constexpr Quaternion(void) : v{0.0f, 0.0f, 0.0f, 1.0f} {}
+        // Non-Default constructor, self explanatory
+        constexpr Quaternion(float xx, float yy, float zz, float ww) : v{xx, yy, zz, ww} {}
+
+        // Copy and move are plain memberwise copies, so the class is trivially copyable
+        Quaternion(const Quaternion& rhs) = default;
+        Quaternion(Quaternion&& rhs) = default;
+        Quaternion& operator=(const Quaternion& rhs) = default;
+        Quaternion& operator=(Quaternion&& rhs) = default;
+
+        // Rotation of angle radians around a unit axis
+        static Quaternion FromAxisAngle(const Vector4& axis, float angle);
+        // Same rotation as RotZ * RotY * RotX, with the angles in radians
+        static Quaternion FromEuler(const Vector4& angles);
+
+        // Concatenation, rhs is applied first (like matrices)
+        constexpr Quaternion operator*(const Quaternion& rhs) const;
+        constexpr Quaternion& operator*=(const Quaternion& rhs);
+
+        // Comparison operators which should use an epsilon defined in
+        // MathUtilities.h to see if the value is within a certain range
+        // in which case we say they are equivalent.
+        constexpr bool operator==(const Quaternion& rhs) const;
+        constexpr bool operator!=(const Quaternion& rhs) const;
+
+        // Dot product of the 4 components
+        constexpr float Dot(const Quaternion& rhs) const;
+        // Computes the true length of the quaternion
+        constexpr float Length(void) const;
+        // Makes the length 1. If the length is zero, it does not modify anything.
+        constexpr void Normalize(void);
+        // Inverse rotation (the inverse if the length is 1)
+        constexpr Quaternion Conjugate(void) const;
+
+        // Rotates a vector (w is kept as it is)
+        constexpr Vector4 Rotate(const Vector4& rhs) const;
+        // Rotation matrix, the quaternion must have length 1
+        constexpr Affine4 ToAffine4(void) const;
+        constexpr Matrix4 ToMatrix4(void) const;
+
+        // Spherical interpolation from a (t = 0) to b (t = 1) along the shortest arc
+        static Quaternion Slerp(const Quaternion& a, const Quaternion& b, float t);
+
+        // Simple print function
+        void Print(void) const
+        {
+            std::printf("%5.3f, %5.3f, %5.3f, %5.3f\n", x, y, z, w);
+        }
+};
+
+/*
+    Everything that does not need sin/cos is constexpr, so it is defined here.
+    Constant expressions can only read the array that was initialized (v), never x,y,z,w
+*/
+
+/**
+* @brief  Hamilton product, the rotation of rhs followed by this one
+*
+* @param rhs:       quaternion to multiply
+* @return quat:     result of the multiplication
+*/
+constexpr Quaternion Quaternion::operator*(const Quaternion& rhs) const
+{
+    return Quaternion(v[3] * rhs.v[0] + v[0] * rhs.v[3] + v[1] * rhs.v[2] - v[2] * rhs.v[1],
+                      v[3] * rhs.v[1] - v[0] * rhs.v[2] + v[1] * rhs.v[3] + v[2] * rhs.v[0],
+                      v[3] * rhs.v[2] + v[0] * rhs.v[1] - v[1] * rhs.v[0] + v[2] * rhs.v[3],
+                      v[3] * rhs.v[3] - v[0] * rhs.v[0] - v[1] * rhs.v[1] - v[2] * rhs.v[2]);
+}
+
+/**
+* @brief  Hamilton product
+*
+* @param rhs:       quaternion to multiply
+* @return *this:    altered quaternion with result of the multiplication
+*/
+constexpr Quaternion& Quaternion::operator*=(const Quaternion& rhs)
+{
+    //Multiply the quaternions
+    *this = *this * rhs;
+    return *this;
+}
+
+/**
+* @brief Comparison operator, should use funciton from MathUtilities.h
+*
+* @param rhs:           quaternion to compare
+* @return true/false:   whether the quaternions are equal
+*/
+constexpr bool Quaternion::operator==(const Quaternion& rhs) const
+{
+    //Compare components using macro function
+    for (int i = 0; i < 4; i++)
+        if (!isEqual(v[i], rhs.v[i]))
+            return false;
+
+    return true;
+}
+
+/**
+* @brief Comparison operator
+*
+* @param rhs:           quaternion to compare
+* @return true/false:   whether the quaternions are different
+*/
+constexpr bool Quaternion::operator!=(const Quaternion& rhs) const
+{
+    //Compare quaternions
+    return !(*this == rhs);
+}
+
+/**
+* @brief  Dot product of the 4 components
+*
+* @param rhs:       quaternion to multiply
+* @return dot:      result of the dot product
+*/
+constexpr float Quaternion::Dot(const Quaternion& rhs) const
+{
+    return v[0] * rhs.v[0] + v[1] * rhs.v[1] + v[2] * rhs.v[2] + v[3] * rhs.v[3];
+}
+
+/**
+* @brief  Computes the true length of the quaternion
+*
+* @param (void)
+* @return length:   length of the quaternion
+*/
+constexpr float Quaternion::Length(void) const
+{
+    return SquareRoot(Dot(*this));
+}
+
+/**
+* @brief  Makes the length 1, so it stays a rotation after many products
+*
+* @param (void)
+*/
+constexpr void Quaternion::Normalize(void)
+{
+    float length = Length();
+
+    //Sanity check: If the length is zero then this function should not modify anything
+    if (length == 0.f)
+        return;
+
+    for (int i = 0; i < 4; i++)
+        v[i] = v[i] / length;
+}
+
+/**
+* @brief  Conjugate, the inverse rotation of a unit quaternion
+*
+* @param (void)
+* @return quat:     quaternion with the vector part negated
+*/
+constexpr Quaternion Quaternion::Conjugate(void) const
+{
+    return Quaternion(-v[0], -v[1], -v[2], v[3]);
+}
+
+/**
+* @brief  Rotates a vector, v + w * t + u x t with t = 2 * (u x v)
+*
+* @param rhs:       vector to rotate
+* @return vec:      rotated vector
+*/
+constexpr Vector4 Quaternion::Rotate(const Vector4& rhs) const
+{
+    Vector4 u(v[0], v[1], v[2]);
+    Vector4 vec(rhs.v[0], rhs.v[1], rhs.v[2]);
+    Vector4 t = u.Cross(vec) * 2.f;
+
+    Vector4 result = vec + t * v[3] + u.Cross(t);
+    result.v[3] = rhs.v[3];
+
+    return result;
+}
+
+/**
+* @brief  Rotation matrix of the quaternion
+*
+* @param (void)
+* @return mtx:      the rotation, without translation
+*/
+constexpr Affine4 Quaternion::ToAffine4(void) const
+{
+    float xx = v[0] * v[0], yy = v[1] * v[1], zz = v[2] * v[2];
+    float xy = v[0] * v[1], xz = v[0] * v[2], yz = v[1] * v[2];
+    float wx = v[3] * v[0], wy = v[3] * v[1], wz = v[3] * v[2];
+
+    return Affine4(1.f - 2.f * (yy + zz), 2.f * (xy - wz),       2.f * (xz + wy),       0.f,
+                   2.f * (xy + wz),       1.f - 2.f * (xx + zz), 2.f * (yz - wx),       0.f,
+                   2.f * (xz - wy),       2.f * (yz + wx),       1.f - 2.f * (xx + yy), 0.f);
+}
+
+/**
+* @brief  Rotation matrix of the quaternion, as a full matrix
+*
+* @param (void)
+* @return mtx:      the rotation, without translation
+*/
+constexpr Matrix4 Quaternion::ToMatrix4(void) const
+{
+    return ToAffine4().ToMatrix4();
+}
+
+#endif
@@ -9,12 +9,10 @@
 \date   18/01/2022
 \brief
 
-This file contains the implementation of the following functions for the
-Math Library assignment.
-Functions include:	Vector4 constructors, operator=, operator-, operator+,
-					operator- (negation), operator *, operator/, operator+=,
-					operator-=, operator*=, operator/=, operator==, operator!=,
-					Dot, Cross, Length, LengthSq, Normalize, Zero
+This file contains the SSE versions of the Vector4 functions and the
+compile-time checks of the Math Library assignment. The constexpr functions
+are defined in Vector4.h.
+Functions include:	DotSSE, CrossSSE
 
 Hours spent on this assignment: ~10
 
@@ -24,306 +22,70 @@ Hours spent on this assignment: ~10
 #include "Vector4.h"		//Header file
 #include "MathUtilities.h"	//Helper macros
 
+#include <type_traits>
 
-/**
-* @brief Default constructor, initializes x,y,z to zeroes, w to defined value
-*
-* @param (void)
-*/
-Vector4::Vector4(void)
-{
-	//Initialize everything to 0
-	for (int i = 0; i < 4; i++)
-		v[i] = 0.0f;
-}
-
-/**
-* @brief Copy constructor, copies every component from the other Vector4
-*
-* @param rhs:	vector to copy from
-*/
-Vector4::Vector4(const Vector4& rhs)
-{
-	//Initialize values
-	for (int i = 0; i < 4; i++)
-		v[i] = rhs.v[i];
-}
-
-/**
-* @brief Non-Default constructor, self explanatory
-*
-* @param xx, yy, zz, ww:	values to make vector with
-*/
-Vector4::Vector4(float xx, float yy, float zz, float ww)
-{
-	//Initialize values
-	x = xx;
-	y = yy;
-	z = zz;
-	w = ww;
-}
-
-/**
-* @brief Assignment operator, does not need to handle self assignment
-*
-* @param rhs:		vector to copy from
-* @return *this:	altered vector
-*/
-Vector4& Vector4::operator=(const Vector4& rhs)
-{
-	//Copy values if the vector is different
-	if (*this != rhs)
-	{
-		for (int i = 0; i < 4; i++)
-			v[i] = rhs.v[i];
-	}
-
-	return *this;
-}
-
-/**
-* @brief Unary negation operator, negates all components and returns a copy
-*
-* @param rhs:		vector to copy from
-* @return vec:		vector with negated values
-*/
-Vector4 Vector4::operator-(void) const
-{
-	//Make new vector with negated values
-	Vector4 vec;
-	for (int i = 0; i < 4; i++)
-		vec.v[i] = -v[i];
-
-	return vec;
-}
-
-/**
-* @brief Addition of 2 vectors
-*
-* @param rhs:		vector to add
-* @return vec:		result of the addition
-*/
-Vector4 Vector4::operator+(const Vector4& rhs) const
-{
-	//Add the values of the vectors
-	Vector4 vec;
-	for (int i = 0; i < 4; i++)
-		vec.v[i] = v[i] + rhs.v[i];
-
-	return vec;
-}
-
-/**
-* @brief Substraction of 2 vectors
-*
-* @param rhs:		vector to substract
-* @return vec:		result of the substraction
-*/
-Vector4 Vector4::operator-(const Vector4& rhs) const
-{
-	//Substract values
-	Vector4 vec;
-	for (int i = 0; i < 4; i++)
-		vec.v[i] = v[i] - rhs.v[i];
+static_assert(std::is_trivially_copyable<Vector4>::value, "Vector4 must be trivially copyable");
 
-	return vec;
-}
-
-/**
-* @brief Multiplication of 2 vectors
-*
-* @param rhs:		vector to multiply
-* @return vec:		result of the multiplication
-*/
-Vector4 Vector4::operator*(const float rhs) const
+//Normalized copy of a vector, for the checks below
+static constexpr Vector4 Normalized(Vector4 vec)
 {
-	//Multiply values
-	Vector4 vec;
-	for (int i = 0; i < 4; i++)
-		vec.v[i] = v[i] * rhs;
-
+	vec.Normalize();
 	return vec;
 }
 
-/**
-* @brief Division of 2 vectors
-*
-* @param rhs:		vector to divide
-* @return vec:		result of the division
-*/
-Vector4 Vector4::operator/(const float rhs) const
-{
-	//Divide values
-	Vector4 vec;
-	for (int i = 0; i < 4; i++)
-		vec.v[i] = v[i] / rhs;
+//Compile-time checks, the constexpr functions must give the expected results
+static_assert(Vector4(1.f, 2.f, 3.f) + Vector4(4.f, 5.f, 6.f) == Vector4(5.f, 7.f, 9.f), "Vector4 addition");
+static_assert(Vector4(4.f, 5.f, 6.f) - Vector4(1.f, 2.f, 3.f) == Vector4(3.f, 3.f, 3.f), "Vector4 substraction");
+static_assert(-Vector4(1.f, -2.f, 3.f, 1.f) == Vector4(-1.f, 2.f, -3.f, -1.f), "Vector4 negation");
+static_assert(Vector4(1.f, 2.f, 3.f) * 2.f == Vector4(2.f, 4.f, 6.f), "Vector4 scaling");
+static_assert(Vector4(2.f, 4.f, 6.f) / 2.f == Vector4(1.f, 2.f, 3.f), "Vector4 division");
+static_assert(Vector4(1.f, 2.f, 3.f).Dot(Vector4(4.f, 5.f, 6.f)) == 32.f, "Vector4 dot product");
+static_assert(Vector4(1.f, 0.f, 0.f).Cross(Vector4(0.f, 1.f, 0.f)) == Vector4(0.f, 0.f, 1.f), "Vector4 cross product");
+static_assert(Vector4(3.f, 4.f, 0.f).Length() == 5.f, "Vector4 length");
+static_assert(Normalized(Vector4(0.f, 0.f, 2.f)) == Vector4(0.f, 0.f, 1.f), "Vector4 normalize");
+static_assert(Normalized(Vector4()) == Vector4(), "Vector4 normalize of a zero vector");
 
-	return vec;
-}
+#ifdef MATH_SSE
 
 /**
-* @brief Addition of 2 vectors
+* @brief  Computes the dot product of two vectors with SSE
 *
-* @param rhs:		vector to add
-* @return *this:	altered vector with result of the addition
-*/
-Vector4& Vector4::operator+=(const Vector4& rhs)
-{
-	//Add vectors
-	*this = *this + rhs;
-	return *this;
-}
-
-/**
-* @brief Substraction of 2 vectors
-*
-* @param rhs:		vector to substract
-* @return *this:	altered vector with result of the substraction
-*/
-Vector4& Vector4::operator-=(const Vector4& rhs)
-{
-	//Substract vectors
-	*this = *this - rhs;
-	return *this;
-}
-
-/**
-* @brief Multiplication of 2 vectors
-*
-* @param rhs:		vector to multiply
-* @return *this:	altered vector with result of the multiplication
-*/
-Vector4& Vector4::operator*=(const float rhs)
-{
-	//Multiply vectors
-	*this = *this * rhs;
-	return *this;
-}
-
-/**
-* @brief Division of 2 vectors
-*
-* @param rhs:		vector to divide
-* @return *this:	altered vector with result of the division
-*/
-Vector4& Vector4::operator/=(const float rhs)
-{
-	//Divide vectors
-	*this = *this / rhs;
-	return *this;
-}
-
-/**
-* @brief Comparison operator, should use funciton from MathUtilities.h
-*
-* @param rhs:			vector to compare
-* @return true/false:	whether the vectors are equal
-*/
-bool Vector4::operator==(const Vector4& rhs) const
-{
-	//Compare vectors using macro function
-	for (int i = 0; i < 4; i++)
-		if (!isEqual(v[i], rhs.v[i]))
-			return false;
-
-	return true;
-}
-
-/**
-* @brief Comparison operator
-*
-* @param rhs:			vector to compare
-* @return true/false:	whether the vectors are different
-*/
-bool Vector4::operator!=(const Vector4& rhs) const
-{
-	//Compare vectors
-	return !(*this == rhs);
-}
-
-/**
-* @brief  Computes the dot product with the other vector.
-*
-* @param rhs:		vector to multiply
+* @param lhs:		first vector
+* @param rhs:		second vector
 * @return dot:		result of the dot product
 */
-float Vector4::Dot(const Vector4& rhs) const
+float Vector4::DotSSE(const Vector4& lhs, const Vector4& rhs)
 {
-	//Multiply row by row and add results (dot product)
-	float dot = 0.f;
-	for (int i = 0; i < 4; i++)
-		dot += v[i] * rhs.v[i];
+	//Multiply component by component and add the halves twice
+	__m128 mul = _mm_mul_ps(_mm_load_ps(lhs.v), _mm_load_ps(rhs.v));
+	__m128 sum = _mm_add_ps(mul, _mm_movehl_ps(mul, mul));
+	sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
 
-	return dot;
+	return _mm_cvtss_f32(sum);
 }
 
 /**
-* @brief  Computes the cross product with the other vector
+* @brief  Computes the cross product of two vectors with SSE
 *
-* @param rhs:		vector to multiply
+* @param lhs:		first vector
+* @param rhs:		second vector
 * @return vec:		result of the cross product
 */
-Vector4 Vector4::Cross(const Vector4& rhs) const
+Vector4 Vector4::CrossSSE(const Vector4& lhs, const Vector4& rhs)
 {
-	//Do the cross product "manually"
 	Vector4 vec;
-	vec.v[0] = v[1] * rhs.v[2] - v[2] * rhs.v[1];
-	vec.v[1] = v[2] * rhs.v[0] - v[0] * rhs.v[2];
-	vec.v[2] = v[0] * rhs.v[1] - v[1] * rhs.v[0];
 
-	return vec;
-}
-
-/**
-* @brief  Computes the true length of the vector
-*
-* @param (void)
-* @return length:	length of the vector
-*/
-float Vector4::Length(void) const
-{
-	//Square root the LengthSq value
-	return sqrt(LengthSq());
-}
+	//a.yzx * b.zxy - a.zxy * b.yzx, w is a.w * b.w - a.w * b.w
+	__m128 a = _mm_load_ps(lhs.v);
+	__m128 b = _mm_load_ps(rhs.v);
+	__m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 aZXY = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2));
+	__m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 bZXY = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 1, 0, 2));
+	_mm_store_ps(vec.v, _mm_sub_ps(_mm_mul_ps(aYZX, bZXY), _mm_mul_ps(aZXY, bYZX)));
+	vec.w = 0.f;
 
-/**
-* @brief  Computes the squared length of the vector
-*
-* @param (void)
-* @return length:	squared length of the vector
-*/
-float Vector4::LengthSq(void) const
-{
-	//Multiply the vector by itself
-	return Dot(*this);
-}
-
-/**
-* @brief  Normalizes the vector to make the final vector be of length 1
-*
-* @param (void)
-*/
-void Vector4::Normalize(void)
-{
-	float length = Length();
-
-	//Sanity check: If the length is zero then this function should not modify anything
-	if (length == 0.f)
-		return;
-
-	//Normalize the vector
-	for (int i = 0; i < 4; i++)
-		v[i] = v[i] / length;
-}
-
-/**
-* @brief  Sets x,y,z to zeroes, w to defined value
-*
-* @param (void)
-*/
-void Vector4::Zero(void)
-{
-	//Set the vector
-	*this = Vector4(0.0f, 0.0f, 0.0f);
+	return vec;
 }
 
+#endif
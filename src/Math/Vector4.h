@@ -2,8 +2,9 @@
 #define VECTOR4_H
 
 #include <cstdio>              // printf
+#include "MathUtilities.h"
 
-class Vector4
+class alignas(16) Vector4
 {
     public:
 
@@ -26,51 +27,320 @@ class Vector4
             
 
         // Default constructor, initializes x,y,z to zeroes, w to defined value
-        Vector4(void);
-        // Copy constructor, copies every component from the other Vector4
-        Vector4(const Vector4& rhs);
+        constexpr Vector4(void) : v{0.0f, 0.0f, 0.0f, 0.0f} {}
         // Non-Default constructor, self explanatory
-        Vector4(float xx, float yy, float zz, float ww = 0.0f);
-        // Assignment operator, does not need to handle self assignment
-        Vector4& operator=(const Vector4& rhs);
+        constexpr Vector4(float xx, float yy, float zz, float ww = 0.0f) : v{xx, yy, zz, ww} {}
+        // Copy and move are plain memberwise copies, so the class is trivially copyable
+        Vector4(const Vector4& rhs) = default;
+        Vector4(Vector4&& rhs) = default;
+        Vector4& operator=(const Vector4& rhs) = default;
+        Vector4& operator=(Vector4&& rhs) = default;
         // Unary negation operator, negates all components and returns a copy
-        Vector4 operator-(void) const;
+        constexpr Vector4 operator-(void) const;
 
         // Basic Vector math operations. Add Vector to Vector B, or Subtract Vector A from
         // Vector B, or multiply a vector with a scalar, or divide a vector by that scalar
-        Vector4 operator+(const Vector4& rhs) const;
-        Vector4 operator-(const Vector4& rhs) const;
-        Vector4 operator*(const float rhs) const;
-        Vector4 operator/(const float rhs) const;
+        constexpr Vector4 operator+(const Vector4& rhs) const;
+        constexpr Vector4 operator-(const Vector4& rhs) const;
+        constexpr Vector4 operator*(const float rhs) const;
+        constexpr Vector4 operator/(const float rhs) const;
         // Same as above, just stores the result in the original vector
-        Vector4& operator+=(const Vector4& rhs);
-        Vector4& operator-=(const Vector4& rhs);
-        Vector4& operator*=(const float rhs);
-        Vector4& operator/=(const float rhs);
+        constexpr Vector4& operator+=(const Vector4& rhs);
+        constexpr Vector4& operator-=(const Vector4& rhs);
+        constexpr Vector4& operator*=(const float rhs);
+        constexpr Vector4& operator/=(const float rhs);
         // Comparison operators which should use an epsilon defined in
         // MathUtilities.h to see if the value is within a certain range
         // in which case we say they are equivalent.
-        bool operator==(const Vector4& rhs) const;
-        bool operator!=(const Vector4& rhs) const;
+        constexpr bool operator==(const Vector4& rhs) const;
+        constexpr bool operator!=(const Vector4& rhs) const;
 
         // Computes the dot product with the other vector. Treat it as 3D vector.
-        float Dot(const Vector4& rhs) const;
+        constexpr float Dot(const Vector4& rhs) const;
         // Computes the cross product with the other vector. Treat it as a 3D vector.
-        Vector4 Cross(const Vector4& rhs) const;
+        constexpr Vector4 Cross(const Vector4& rhs) const;
         // Computes the true length of the vector
-        float Length(void) const;
+        constexpr float Length(void) const;
         // Computes the squared length of the vector
-        float LengthSq(void) const;
+        constexpr float LengthSq(void) const;
         // Normalizes the vector to make the final vector be of length 1. If the length is zero
         // then this function should not modify anything.
-        void Normalize(void);
+        constexpr void Normalize(void);
         // Sets x,y,z to zeroes, w to defined value
-        void Zero(void);
+        constexpr void Zero(void);
         // Already implemented, simple print function
         void Print(void) const
         {
             std::printf("%5.3f, %5.3f, %5.3f, %5.3f\n", x, y, z, w);
         }
+
+    private:
+
+#ifdef MATH_SSE
+        // SSE versions of Dot and Cross, only used outside of constant expressions
+        static float DotSSE(const Vector4& lhs, const Vector4& rhs);
+        static Vector4 CrossSSE(const Vector4& lhs, const Vector4& rhs);
+#endif
 };
 
+/*
+    Everything is constexpr, so it is defined here. Constant expressions can only
+    read the array that was initialized (v), never x,y,z,w
+*/
+
+/**
+* @brief Unary negation operator, negates all components and returns a copy
+*
+* @param rhs:       vector to copy from
+* @return vec:      vector with negated values
+*/
+constexpr Vector4 Vector4::operator-(void) const
+{
+    //Make new vector with negated values
+    Vector4 vec;
+    for (int i = 0; i < 4; i++)
+        vec.v[i] = -v[i];
+
+    return vec;
+}
+
+/**
+* @brief Addition of 2 vectors
+*
+* @param rhs:       vector to add
+* @return vec:      result of the addition
+*/
+constexpr Vector4 Vector4::operator+(const Vector4& rhs) const
+{
+    //Add the values of the vectors
+    Vector4 vec;
+    for (int i = 0; i < 4; i++)
+        vec.v[i] = v[i] + rhs.v[i];
+
+    return vec;
+}
+
+/**
+* @brief Substraction of 2 vectors
+*
+* @param rhs:       vector to substract
+* @return vec:      result of the substraction
+*/
+constexpr Vector4 Vector4::operator-(const Vector4& rhs) const
+{
+    //Substract values
+    Vector4 vec;
+    for (int i = 0; i < 4; i++)
+        vec.v[i] = v[i] - rhs.v[i];
+
+    return vec;
+}
+
+/**
+* @brief Multiplication of 2 vectors
+*
+* @param rhs:       vector to multiply
+* @return vec:      result of the multiplication
+*/
+constexpr Vector4 Vector4::operator*(const float rhs) const
+{
+    //Multiply values
+    Vector4 vec;
+    for (int i = 0; i < 4; i++)
+        vec.v[i] = v[i] * rhs;
+
+    return vec;
+}
+
+/**
+* @brief Division of 2 vectors
+*
+* @param rhs:       vector to divide
+* @return vec:      result of the division
+*/
+constexpr Vector4 Vector4::operator/(const float rhs) const
+{
+    //Divide values
+    Vector4 vec;
+    for (int i = 0; i < 4; i++)
+        vec.v[i] = v[i] / rhs;
+
+    return vec;
+}
+
+/**
+* @brief Addition of 2 vectors
+*
+* @param rhs:       vector to add
+* @return *this:    altered vector with result of the addition
+*/
+constexpr Vector4& Vector4::operator+=(const Vector4& rhs)
+{
+    //Add vectors
+    *this = *this + rhs;
+    return *this;
+}
+
+/**
+* @brief Substraction of 2 vectors
+*
+* @param rhs:       vector to substract
+* @return *this:    altered vector with result of the substraction
+*/
+constexpr Vector4& Vector4::operator-=(const Vector4& rhs)
+{
+    //Substract vectors
+    *this = *this - rhs;
+    return *this;
+}
+
+/**
+* @brief Multiplication of 2 vectors
+*
+* @param rhs:       vector to multiply
+* @return *this:    altered vector with result of the multiplication
+*/
+constexpr Vector4& Vector4::operator*=(const float rhs)
+{
+    //Multiply vectors
+    *this = *this * rhs;
+    return *this;
+}
+
+/**
+* @brief Division of 2 vectors
+*
+* @param rhs:       vector to divide
+* @return *this:    altered vector with result of the division
+*/
+constexpr Vector4& Vector4::operator/=(const float rhs)
+{
+    //Divide vectors
+    *this = *this / rhs;
+    return *this;
+}
+
+/**
+* @brief Comparison operator, should use funciton from MathUtilities.h
+*
+* @param rhs:           vector to compare
+* @return true/false:   whether the vectors are equal
+*/
+constexpr bool Vector4::operator==(const Vector4& rhs) const
+{
+    //Compare vectors using macro function
+    for (int i = 0; i < 4; i++)
+        if (!isEqual(v[i], rhs.v[i]))
+            return false;
+
+    return true;
+}
+
+/**
+* @brief Comparison operator
+*
+* @param rhs:           vector to compare
+* @return true/false:   whether the vectors are different
+*/
+constexpr bool Vector4::operator!=(const Vector4& rhs) const
+{
+    //Compare vectors
+    return !(*this == rhs);
+}
+
+/**
+* @brief  Computes the dot product with the other vector.
+*
+* @param rhs:       vector to multiply
+* @return dot:      result of the dot product
+*/
+constexpr float Vector4::Dot(const Vector4& rhs) const
+{
+#ifdef MATH_SSE
+    if (!MATH_CONSTANT_EVALUATED())
+        return DotSSE(*this, rhs);
+#endif
+
+    //Multiply row by row and add results (dot product)
+    float dot = 0.f;
+    for (int i = 0; i < 4; i++)
+        dot += v[i] * rhs.v[i];
+
+    return dot;
+}
+
+/**
+* @brief  Computes the cross product with the other vector
+*
+* @param rhs:       vector to multiply
+* @return vec:      result of the cross product
+*/
+constexpr Vector4 Vector4::Cross(const Vector4& rhs) const
+{
+#ifdef MATH_SSE
+    if (!MATH_CONSTANT_EVALUATED())
+        return CrossSSE(*this, rhs);
+#endif
+
+    //Do the cross product "manually"
+    Vector4 vec;
+    vec.v[0] = v[1] * rhs.v[2] - v[2] * rhs.v[1];
+    vec.v[1] = v[2] * rhs.v[0] - v[0] * rhs.v[2];
+    vec.v[2] = v[0] * rhs.v[1] - v[1] * rhs.v[0];
+
+    return vec;
+}
+
+/**
+* @brief  Computes the true length of the vector
+*
+* @param (void)
+* @return length:   length of the vector
+*/
+constexpr float Vector4::Length(void) const
+{
+    //Square root the LengthSq value
+    return SquareRoot(LengthSq());
+}
+
+/**
+* @brief  Computes the squared length of the vector
+*
+* @param (void)
+* @return length:   squared length of the vector
+*/
+constexpr float Vector4::LengthSq(void) const
+{
+    //Multiply the vector by itself
+    return Dot(*this);
+}
+
+/**
+* @brief  Normalizes the vector to make the final vector be of length 1
+*
+* @param (void)
+*/
+constexpr void Vector4::Normalize(void)
+{
+    float length = Length();
+
+    //Sanity check: If the length is zero then this function should not modify anything
+    if (length == 0.f)
+        return;
+
+    //Normalize the vector
+    *this /= length;
+}
+
+/**
+* @brief  Sets x,y,z to zeroes, w to defined value
+*
+* @param (void)
+*/
+constexpr void Vector4::Zero(void)
+{
+    //Set the vector
+    *this = Vector4(0.0f, 0.0f, 0.0f);
+}
+
 #endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 
 #include "Rasterizer.h"
 #include "FrameBuffer.h"
+#include <algorithm>
+#include <cmath>
 
 namespace Rasterizer
 {
@@ -12,6 +14,15 @@ int Round(float f)
     return i;
 }
 
+// Converts a screen coordinate to fixed point with TILED_SUBPIXELS steps per pixel
+const int TILED_SUBPIXELS = 16;
+const int TILE_SIZE       = 8;
+
+long long ToFixed(float f)
+{
+    return static_cast<long long>(std::floor(f * TILED_SUBPIXELS + 0.5f));
+}
+
 int Ceiling(float f)
 {
     int i = static_cast<int>(f);
@@ -22,8 +33,63 @@ int Ceiling(float f)
     return i + 1;
 }
 
-void DrawMidpointLine(const Vertex & v0, const Vertex & v1)
+// Liang-Barsky clipping of the line to the pixel centers of the screen, so the
+// midpoint loop never leaves it. Returns false if nothing is left
+bool ClipLineToScreen(const FrameBuffer & target, Vertex & v0, Vertex & v1)
 {
+    float xMax = target.GetWidth() - 1.f;
+    float yMax = target.GetHeight() - 1.f;
+
+    if (xMax < 0.f || yMax < 0.f)
+        return false;
+
+    float dx   = v1.position.x - v0.position.x;
+    float dy   = v1.position.y - v0.position.y;
+    float p[4] = {-dx, dx, -dy, dy};
+    float q[4] = {v0.position.x, xMax - v0.position.x, v0.position.y, yMax - v0.position.y};
+    float t0 = 0.f, t1 = 1.f;
+
+    for (int i = 0; i < 4; i++)
+    {
+        // Parallel to the edge: either fully inside or fully outside of it
+        if (p[i] == 0.f)
+        {
+            if (q[i] < 0.f)
+                return false;
+            continue;
+        }
+
+        float t = q[i] / p[i];
+        if (p[i] < 0.f)
+            t0 = std::max(t0, t);
+        else
+            t1 = std::min(t1, t);
+    }
+
+    if (t0 > t1)
+        return false;
+
+    Vertex start = v0;
+    if (t0 > 0.f)
+    {
+        v0.position = start.position + (v1.position - start.position) * t0;
+        v0.color    = start.color + (v1.color - start.color) * t0;
+    }
+    if (t1 < 1.f)
+    {
+        v1.position = start.position + (v1.position - start.position) * t1;
+        v1.color    = start.color + (v1.color - start.color) * t1;
+    }
+
+    return true;
+}
+
+void DrawMidpointLine(FrameBuffer & target, const Vertex & start, const Vertex & end)
+{
+    Vertex v0 = start, v1 = end;
+    if (!ClipLineToScreen(target, v0, v1))
+        return;
+
     int x = Round(v0.position.x);
     int y = Round(v0.position.y);
 
@@ -52,7 +118,7 @@ void DrawMidpointLine(const Vertex & v0, const Vertex & v1)
     float g = v0.color.g;
     float b = v0.color.b;
 
-    FrameBuffer::SetPixel(x, y, static_cast<unsigned char>(r * 255.99), static_cast<unsigned char>(g * 255.99), static_cast<unsigned char>(b * 255.99));
+    target.SetPixelUnchecked(x, y, static_cast<unsigned char>(r * 255.99), static_cast<unsigned char>(g * 255.99), static_cast<unsigned char>(b * 255.99));
 
     if (abs(dy) > abs(dx)) // |m|>1
     {
@@ -73,7 +139,7 @@ void DrawMidpointLine(const Vertex & v0, const Vertex & v1)
             else
                 dstart += dn;
 
-            FrameBuffer::SetPixel(x, y, static_cast<unsigned char>(r * 255.99), static_cast<unsigned char>(g * 255.99), static_cast<unsigned char>(b * 255.99));
+            target.SetPixelUnchecked(x, y, static_cast<unsigned char>(r * 255.99), static_cast<unsigned char>(g * 255.99), static_cast<unsigned char>(b * 255.99));
 
             r += rInc;
             g += gInc;
@@ -99,7 +165,7 @@ void DrawMidpointLine(const Vertex & v0, const Vertex & v1)
             else
                 dstart += de;
 
-            FrameBuffer::SetPixel(x, y, static_cast<unsigned char>(r * 255.99), static_cast<unsigned char>(g * 255.99), static_cast<unsigned char>(b * 255.99));
+            target.SetPixelUnchecked(x, y, static_cast<unsigned char>(r * 255.99), static_cast<unsigned char>(g * 255.99), static_cast<unsigned char>(b * 255.99));
 
             r += rInc;
             g += gInc;
@@ -108,7 +174,7 @@ void DrawMidpointLine(const Vertex & v0, const Vertex & v1)
     }
 }
 
-void DrawTriangleSolid(const Vertex & v0, const Vertex & v1, const Vertex & v2)
+void DrawTriangleSolid(FrameBuffer & target, const Vertex & v0, const Vertex & v1, const Vertex & v2)
 {
     // Select TOP, MIDDLE and BOTTOM vertices
     // --------------------------------------
@@ -207,10 +273,14 @@ void DrawTriangleSolid(const Vertex & v0, const Vertex & v1, const Vertex & v2)
     // BLUE
     float v1B[3] = {middle->position.x - top->position.x, middle->position.y - top->position.y, static_cast<float>(middle->color.b - top->color.b)};
     float v2B[3] = {bottom->position.x - top->position.x, bottom->position.y - top->position.y, static_cast<float>(bottom->color.b - top->color.b)};
+    // DEPTH
+    float v1Z[3] = {middle->position.x - top->position.x, middle->position.y - top->position.y, middle->position.z - top->position.z};
+    float v2Z[3] = {bottom->position.x - top->position.x, bottom->position.y - top->position.y, bottom->position.z - top->position.z};
     // NORMALS
     float nR[3] = {v1R[1] * v2R[2] - v1R[2] * v2R[1], v1R[2] * v2R[0] - v1R[0] * v2R[2], v1R[0] * v2R[1] - v1R[1] * v2R[0]};
     float nG[3] = {v1G[1] * v2G[2] - v1G[2] * v2G[1], v1G[2] * v2G[0] - v1G[0] * v2G[2], v1G[0] * v2G[1] - v1G[1] * v2G[0]};
     float nB[3] = {v1B[1] * v2B[2] - v1B[2] * v2B[1], v1B[2] * v2B[0] - v1B[0] * v2B[2], v1B[0] * v2B[1] - v1B[1] * v2B[0]};
+    float nZ[3] = {v1Z[1] * v2Z[2] - v1Z[2] * v2Z[1], v1Z[2] * v2Z[0] - v1Z[0] * v2Z[2], v1Z[0] * v2Z[1] - v1Z[1] * v2Z[0]};
     // Increments
     float rIncX = -nR[0] / nR[2];
     float rIncY = -nR[1] / nR[2];
@@ -218,12 +288,14 @@ void DrawTriangleSolid(const Vertex & v0, const Vertex & v1, const Vertex & v2)
     float gIncY = -nG[1] / nG[2];
     float bIncX = -nB[0] / nB[2];
     float bIncY = -nB[1] / nB[2];
+    float zIncX = -nZ[0] / nZ[2];
+    float zIncY = -nZ[1] / nZ[2];
 
     float rL = top->color.r;
     float gL = top->color.g;
     float bL = top->color.b;
 
-    float r, g, b;
+    float r, g, b, z;
 
     // Start the loop, from the y_top to y_middle
     while (y <= yMax)
@@ -236,17 +308,10 @@ void DrawTriangleSolid(const Vertex & v0, const Vertex & v1, const Vertex & v2)
         g = gL;
         b = bL;
 
+        // Depth is evaluated from the plane equation at the first pixel of the span
+        z = top->position.z + (x - top->position.x) * zIncX + (y - top->position.y) * zIncY;
 
-        while (x <= xMax)
-        {
-            FrameBuffer::SetPixel(x, y, static_cast<unsigned char>(r * 255.99), static_cast<unsigned char>(g * 255.99), static_cast<unsigned char>(b * 255.99));
-
-            ++x;
-
-            r += rIncX;
-            g += gIncX;
-            b += bIncX;
-        }
+        target.DrawSpan(y, x, xMax, r, g, b, z, rIncX, gIncX, bIncX, zIncX);
 
         xL += xIncLeft;
         xR += xIncRight;
@@ -290,17 +355,11 @@ void DrawTriangleSolid(const Vertex & v0, const Vertex & v1, const Vertex & v2)
         g = gL;
         b = bL;
 
-        // Loop along the scanline, from left to right
-        while (x <= xMax)
-        {
-            FrameBuffer::SetPixel(x, y, static_cast<unsigned char>(r * 255.99), static_cast<unsigned char>(g * 255.99), static_cast<unsigned char>(b * 255.99));
-
-            ++x;
+        // Depth is evaluated from the plane equation at the first pixel of the span
+        z = top->position.z + (x - top->position.x) * zIncX + (y - top->position.y) * zIncY;
 
-            r += rIncX;
-            g += gIncX;
-            b += bIncX;
-        }
+        // Loop along the scanline, from left to right
+        target.DrawSpan(y, x, xMax, r, g, b, z, rIncX, gIncX, bIncX, zIncX);
 
         xL += xIncLeft;
         xR += xIncRight;
@@ -312,4 +371,168 @@ void DrawTriangleSolid(const Vertex & v0, const Vertex & v1, const Vertex & v2)
     }
 }
 
+void DrawTriangleTiled(FrameBuffer & target, const Vertex & v0, const Vertex & v1, const Vertex & v2, int clipX0, int clipY0, int clipX1, int clipY1)
+{
+    // Make the triangle positive (clockwise on screen), so the inside of every edge is positive
+    // -----------------------------------------------------------------------------------------
+    const Vertex *p0 = &v0, *p1 = &v1, *p2 = &v2;
+
+    long long x0 = ToFixed(p0->position.x), y0 = ToFixed(p0->position.y);
+    long long x1 = ToFixed(p1->position.x), y1 = ToFixed(p1->position.y);
+    long long x2 = ToFixed(p2->position.x), y2 = ToFixed(p2->position.y);
+
+    long long area = (x1 - x0) * (y2 - y0) - (y1 - y0) * (x2 - x0);
+    if (area == 0)
+        return;
+
+    if (area < 0)
+    {
+        std::swap(p1, p2);
+        std::swap(x1, x2);
+        std::swap(y1, y2);
+    }
+
+    // Edge functions E(x, y) = A * (x - xa) + B * (y - ya), for the edges 0->1, 1->2 and 2->0
+    // ----------------------------------------------------------------------------------------
+    long long xa[3] = {x0, x1, x2};
+    long long ya[3] = {y0, y1, y2};
+    long long A[3], B[3], bias[3];
+
+    for (int i = 0; i < 3; i++)
+    {
+        long long dx = xa[(i + 1) % 3] - xa[i];
+        long long dy = ya[(i + 1) % 3] - ya[i];
+
+        A[i] = -dy;
+        B[i] = dx;
+
+        // Top-left fill convention: pixels exactly on a top or left edge are drawn,
+        // the ones on the other edges belong to the neighbouring triangle
+        bool topLeft = dy < 0 || (dy == 0 && dx > 0);
+        bias[i]      = topLeft ? 0 : -1;
+    }
+
+    // Color and depth gradients (Plane Equation Parameters)
+    // -----------------------------------------------------
+    float ex1 = p1->position.x - p0->position.x, ey1 = p1->position.y - p0->position.y;
+    float ex2 = p2->position.x - p0->position.x, ey2 = p2->position.y - p0->position.y;
+    float det = ex1 * ey2 - ex2 * ey1;
+
+    float a0[4]   = {p0->color.r, p0->color.g, p0->color.b, p0->position.z};
+    float a1[4]   = {p1->color.r, p1->color.g, p1->color.b, p1->position.z};
+    float a2[4]   = {p2->color.r, p2->color.g, p2->color.b, p2->position.z};
+    float incX[4], incY[4];
+
+    for (int i = 0; i < 4; i++)
+    {
+        incX[i] = ((a1[i] - a0[i]) * ey2 - (a2[i] - a0[i]) * ey1) / det;
+        incY[i] = ((a2[i] - a0[i]) * ex1 - (a1[i] - a0[i]) * ex2) / det;
+    }
+
+    // Bounding box, clamped to the screen and the clip rectangle, and aligned to the tiles
+    // -----------------------------------------------------------------------------------
+    int width  = std::min(target.GetWidth(), clipX1);
+    int height = std::min(target.GetHeight(), clipY1);
+
+    int xMin = static_cast<int>(std::max(static_cast<long long>(std::max(0, clipX0)), (std::min({x0, x1, x2}) + TILED_SUBPIXELS - 1) / TILED_SUBPIXELS));
+    int yMin = static_cast<int>(std::max(static_cast<long long>(std::max(0, clipY0)), (std::min({y0, y1, y2}) + TILED_SUBPIXELS - 1) / TILED_SUBPIXELS));
+    int xMax = static_cast<int>(std::min(static_cast<long long>(width - 1), std::max({x0, x1, x2}) / TILED_SUBPIXELS));
+    int yMax = static_cast<int>(std::min(static_cast<long long>(height - 1), std::max({y0, y1, y2}) / TILED_SUBPIXELS));
+
+    xMin &= ~(TILE_SIZE - 1);
+    yMin &= ~(TILE_SIZE - 1);
+
+    // Step of each edge function per pixel, and over the whole tile
+    long long stepX[3], stepY[3], tileX[3], tileY[3];
+    for (int i = 0; i < 3; i++)
+    {
+        stepX[i] = A[i] * TILED_SUBPIXELS;
+        stepY[i] = B[i] * TILED_SUBPIXELS;
+        tileX[i] = stepX[i] * (TILE_SIZE - 1);
+        tileY[i] = stepY[i] * (TILE_SIZE - 1);
+    }
+
+    // Walk the tiles
+    // --------------
+    for (int ty = yMin; ty <= yMax; ty += TILE_SIZE)
+    {
+        for (int tx = xMin; tx <= xMax; tx += TILE_SIZE)
+        {
+            // Edge functions at the top-left pixel of the tile
+            long long e[3];
+            bool      reject = false;
+            bool      accept = true;
+
+            for (int i = 0; i < 3; i++)
+            {
+                e[i] = A[i] * (tx * TILED_SUBPIXELS - xa[i]) + B[i] * (ty * TILED_SUBPIXELS - ya[i]) + bias[i];
+
+                // Largest and smallest value of the edge function over the tile corners
+                long long eMax = e[i] + std::max(0LL, tileX[i]) + std::max(0LL, tileY[i]);
+                long long eMin = e[i] + std::min(0LL, tileX[i]) + std::min(0LL, tileY[i]);
+
+                if (eMax < 0)
+                    reject = true;
+                if (eMin < 0)
+                    accept = false;
+            }
+
+            // Trivial reject: the tile is completely outside one of the edges
+            if (reject)
+                continue;
+
+            int xEnd = std::min(tx + TILE_SIZE, width);
+            int yEnd = std::min(ty + TILE_SIZE, height);
+
+            // Attributes at the top-left pixel of the tile
+            float rowR = a0[0] + (tx - p0->position.x) * incX[0] + (ty - p0->position.y) * incY[0];
+            float rowG = a0[1] + (tx - p0->position.x) * incX[1] + (ty - p0->position.y) * incY[1];
+            float rowB = a0[2] + (tx - p0->position.x) * incX[2] + (ty - p0->position.y) * incY[2];
+            float rowZ = a0[3] + (tx - p0->position.x) * incX[3] + (ty - p0->position.y) * incY[3];
+
+            for (int y = ty; y < yEnd; y++)
+            {
+                // Trivially accepted tiles are whole spans, without edge tests
+                if (accept)
+                {
+                    target.DrawSpan(y, tx, xEnd - 1, rowR, rowG, rowB, rowZ, incX[0], incX[1], incX[2], incX[3]);
+
+                    rowR += incY[0];
+                    rowG += incY[1];
+                    rowB += incY[2];
+                    rowZ += incY[3];
+                    continue;
+                }
+
+                long long e0 = e[0], e1 = e[1], e2 = e[2];
+                float     r = rowR, g = rowG, b = rowB, z = rowZ;
+
+                for (int x = tx; x < xEnd; x++)
+                {
+                    if ((e0 | e1 | e2) >= 0 && target.DepthTestUnchecked(x, y, z))
+                        target.SetPixelUnchecked(x, y, static_cast<unsigned char>(r * 255.99), static_cast<unsigned char>(g * 255.99), static_cast<unsigned char>(b * 255.99));
+
+                    e0 += stepX[0];
+                    e1 += stepX[1];
+                    e2 += stepX[2];
+
+                    r += incX[0];
+                    g += incX[1];
+                    b += incX[2];
+                    z += incX[3];
+                }
+
+                e[0] += stepY[0];
+                e[1] += stepY[1];
+                e[2] += stepY[2];
+
+                rowR += incY[0];
+                rowG += incY[1];
+                rowB += incY[2];
+                rowZ += incY[3];
+            }
+        }
+    }
+}
+
 } // namespace Rasterizer
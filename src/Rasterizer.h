@@ -1,6 +1,12 @@
 
+#pragma once
+
 #include "Math/Point4.h"
+#include <climits>
+
+class FrameBuffer;
 
+// Every function draws into the render target it is given
 namespace Rasterizer
 {
 
@@ -10,8 +16,15 @@ struct Vertex
     Point4 color;
 };
 
-void DrawMidpointLine(const Vertex & v1, const Vertex & v2);
+// Clipped to the screen first, the endpoints can be anywhere
+void DrawMidpointLine(FrameBuffer & target, const Vertex & v1, const Vertex & v2);
+
+void DrawTriangleSolid(FrameBuffer & target, const Vertex & p0, const Vertex & p1, const Vertex & p2);
 
-void DrawTriangleSolid(const Vertex & p0, const Vertex & p1, const Vertex & p2);
+// Same output as DrawTriangleSolid, using integer edge functions over 8x8 tiles
+// Only the pixels inside the clip rectangle [x0, x1) x [y0, y1) are written, its
+// corners must be multiples of 8
+void DrawTriangleTiled(FrameBuffer & target, const Vertex & p0, const Vertex & p1, const Vertex & p2,
+                       int clipX0 = 0, int clipY0 = 0, int clipX1 = INT_MAX, int clipY1 = INT_MAX);
 
 } // namespace Rasterize
\ No newline at end of file
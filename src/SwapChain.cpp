@@ -0,0 +1,135 @@
+#include "SwapChain.h"
+
+#include <algorithm>
+
+
+SwapChain::~SwapChain()
+{
+    Free();
+}
+
+/**
+* @brief Init:      create the buffers and hand the window over to the presentation thread
+*
+* @param window:    window to display the frames in, its size is the size of the buffers.
+*                   From now on only the presentation thread draws to it, the calling thread
+*                   can still poll its events
+* @param layout:    memory layout of the buffers
+* @param buffers:   number of buffers, from 1 (the upload waits for the drawing) to MAX_BUFFERS
+*/
+void SwapChain::Init(sf::RenderWindow & window, FrameBuffer::Layout layout, int buffers)
+{
+    Free();
+
+    this->window = &window;
+    count = std::min(std::max(buffers, 1), +MAX_BUFFERS);    //A copy, std::min takes references
+
+    sf::Vector2u size = window.getSize();
+    for (int i = 0; i < count; i++)
+        frames[i].Init(size.x, size.y, layout);
+
+    rendered = 0;
+    uploaded = 0;
+    quit     = false;
+
+    //An OpenGL context can only be active in one thread
+    window.setActive(false);
+    presenter = std::thread(&SwapChain::PresentLoop, this);
+}
+
+/**
+* @brief Free:      display the queued frames, stop the presentation thread and free the buffers
+*
+* @param (void)
+*/
+void SwapChain::Free()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    queued.notify_one();
+
+    if (presenter.joinable())
+        presenter.join();
+
+    for (FrameBuffer & frame : frames)
+        frame.Free();
+
+    count  = 0;
+    window = nullptr;
+}
+
+/**
+* @brief Acquire:   get the buffer to draw the next frame into
+*
+* @param (void)
+* @return:          the buffer, that belongs to the render thread until Present is called
+*/
+FrameBuffer & SwapChain::Acquire()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    released.wait(lock, [this] { return rendered - uploaded < static_cast<unsigned>(count); });
+
+    return frames[rendered % count];
+}
+
+/**
+* @brief Present:   queue the buffer returned by Acquire to be displayed
+*
+* @param (void)
+*/
+void SwapChain::Present()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        rendered++;
+    }
+    queued.notify_one();
+}
+
+/**
+* @brief PresentLoop: upload and display the queued frames in order, until Free is called
+*
+* @param (void)
+*/
+void SwapChain::PresentLoop()
+{
+    window->setActive(true);
+
+    //The texture lives in the context of this thread
+    sf::Vector2u size = window->getSize();
+    sf::Texture  texture;
+    sf::Sprite   sprite;
+    texture.create(size.x, size.y);
+    sprite.setTexture(texture);
+
+    for (;;)
+    {
+        FrameBuffer * frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            queued.wait(lock, [this] { return quit || uploaded != rendered; });
+
+            //Quit once every queued frame is shown
+            if (uploaded == rendered)
+                break;
+
+            frame = &frames[uploaded % count];
+        }
+
+        frame->UpdateTexture(texture);
+
+        //The pixels are in the texture, the buffer can be drawn again while the frame is displayed
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            uploaded++;
+        }
+        released.notify_one();
+
+        window->draw(sprite);
+        window->display();
+    }
+
+    window->setActive(false);
+}
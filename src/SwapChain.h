@@ -0,0 +1,42 @@
+#pragma once
+
+#include "FrameBuffer.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+// Ring of frame buffers shared by the render thread and a presentation thread.
+// The render thread draws the next frame while the presentation thread uploads the
+// previous one to the window and displays it. Frames are shown in the order they were
+// rendered, none is dropped: the render thread waits when every buffer is queued.
+class SwapChain
+{
+  public:
+    static constexpr int MAX_BUFFERS = 3;
+
+    ~SwapChain();
+
+    void Init(sf::RenderWindow & window, FrameBuffer::Layout layout = FrameBuffer::LAYOUT_LINEAR, int buffers = 2);
+    void Free();
+
+    FrameBuffer & Acquire();    //Wait for a buffer that is not queued or being uploaded
+    void Present();             //Queue the acquired buffer to be displayed
+
+    int GetBufferCount() const { return count; }
+
+  private:
+    void PresentLoop();
+
+    sf::RenderWindow * window = nullptr;    //Only used by the presentation thread, which owns its context
+    FrameBuffer        frames[MAX_BUFFERS];
+    int                count    = 0;
+
+    std::thread             presenter;
+    std::mutex              mutex;
+    std::condition_variable queued;         //A frame was queued by the render thread, or quit
+    std::condition_variable released;       //A frame was uploaded, its buffer can be drawn again
+    unsigned                rendered  = 0;  //Frames queued by the render thread
+    unsigned                uploaded  = 0;  //Frames uploaded by the presentation thread
+    bool                    quit      = false;
+};
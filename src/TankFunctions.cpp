@@ -1,6 +1,8 @@
 
 #include "TankFunctions.h"  //Header file
 
+#include <algorithm>        //std::sort
+
 
 /**
 * @brief Tank_Initialize: initialize tank object
@@ -19,10 +21,31 @@ void Tank::Tank_Initialize()
 
     TOTAL_obj = parser->objects.size();
 
+    //Objects moved by the user, looked up once
+    obj_body   = FindObject("body");
+    obj_turret = FindObject("turret");
+    obj_joint  = FindObject("joint");
+    for (int i = 0; i < 4; i++)
+        obj_wheels[i] = FindObject("wheel" + std::to_string(i + 1));
+
     //Number of faces per cube and number of vertices per face
     max_faces = parser->faces.size();
 
-    //Get view matrix
+    //Vertices of the mesh as structure of arrays, to transform them in batches
+    model_vertices.Resize(parser->vertices.size());
+    for (size_t v = 0; v < parser->vertices.size(); v++)
+        model_vertices.Set(v, parser->vertices[v]);
+
+    //Scratch buffers for the transformed vertices of one object
+    clip_vertices.Resize(parser->vertices.size());
+    screen_vertices.resize(parser->vertices.size());
+    screen_codes.resize(parser->vertices.size());
+    guard_codes.resize(parser->vertices.size());
+
+    //Start the threads of the binned rasterizer
+    tile_renderer.Init(WIDTH, HEIGHT, raster_threads);
+
+    //Get viewport matrix and camera
     Viewport_Transformation();
     Perspective_Projection();
 
@@ -42,20 +65,73 @@ void Tank::Tank_Initialize()
 /**
 * @brief Tank_Update: renders the current state of the tank
 *
-* @param (void)
+* @param target:      render target, WIDTH x HEIGHT
+* @param input:       whether to read the keyboard (false when rendering offscreen)
 */
-void Tank::Tank_Update()
+void Tank::Tank_Update(FrameBuffer& target, bool input)
 {
     //Get inputs from the user
-    draw_mode_solid = GetInput();
-    
+    if (input)
+        draw_mode_solid = GetInput();
 
-    //Calculate the new state of each object
+    culled_faces = 0;
+    rejected_faces = 0;
+
+
+    //Need to calculate the model to world matrices first
+    //Because they are the same for the whole object
+    //Only the objects that moved (or whose parent moved) are rebuilt
+    UpdateWorldMatrices();
+
+    //World to clip space, cached by the camera
+    const Affine4& view = camera.GetView();
+    const Matrix4& view_proj = camera.GetViewProjection();
+
+    //Depth of the origin of each object in camera space (the camera looks down -z)
+    std::vector<int> order(TOTAL_obj);
+    std::vector<float> depth(TOTAL_obj);
     for (int obj = 0; obj < TOTAL_obj; obj++)
-    {     
-        //Need to calculate the model to world matrix first
-        //Because it is the same for the whole object
-        Matrix4 m2w = ModelToWorld(parser->objects[obj], true);
+    {
+        const Affine4& m2w = parser->objects[obj].m2w;
+        order[obj] = obj;
+        depth[obj] = (view * Point4(m2w.m[0][3], m2w.m[1][3], m2w.m[2][3])).z;
+    }
+
+    //Draw front to back (closest origin first) so the depth test rejects hidden pixels early
+    std::sort(order.begin(), order.end(), [&depth](int a, int b)
+    {
+        return depth[a] > depth[b];
+    });
+
+    //Half the size of the view in x and y, the screen edges in clip space are at +-extent * w
+    //The guard band is larger, triangles that only cross the screen edges are not clipped
+    float extent_x = view_width / 2.f;
+    float extent_y = view_height / 2.f;
+    float guard_x = extent_x * Clipper::GUARD_BAND;
+    float guard_y = extent_y * Clipper::GUARD_BAND;
+
+    //Calculate the new state of each object
+    for (int obj : order)
+    {
+        //Model to world, view and perspective projection in a single matrix for the whole object
+        //(m2w is affine, it only becomes a full matrix here)
+        Matrix4 clip = view_proj * parser->objects[obj].m2w;
+
+        //Transform every vertex of the mesh once, the faces share them
+        //Transform vertices: perspective projection, model to world and view, still homogeneous
+        clip.TransformPoints(model_vertices, clip_vertices, false);
+
+        for (size_t v = 0; v < screen_vertices.size(); v++)
+        {
+            Point4 homogeneous = clip_vertices.Get(v);
+            screen_codes[v] = Clipper::OutCode(homogeneous, extent_x, extent_y);
+            guard_codes[v] = Clipper::OutCode(homogeneous, guard_x, guard_y);
+
+            //Only the vertices inside the guard band are safe to divide, the others
+            //are only used by faces that go through the clipper
+            if (guard_codes[v] == 0)
+                screen_vertices[v] = ClipToScreen(homogeneous);
+        }
 
         //Vertices of the cube
         for (int i = 0; i < max_faces; i++)
@@ -63,41 +139,154 @@ void Tank::Tank_Update()
             auto face = parser->faces[i];
             Rasterizer::Vertex vtx[3];      //Each vertex of the triangle
 
+            //The whole face is outside of one of the planes of the frustum
+            if (screen_codes[face.indices[0]] & screen_codes[face.indices[1]] & screen_codes[face.indices[2]])
+            {
+                rejected_faces++;
+                continue;
+            }
+
+            //Planes of the guard band crossed by the face
+            unsigned planes = guard_codes[face.indices[0]] | guard_codes[face.indices[1]] | guard_codes[face.indices[2]];
+
             for (int j = 0; j < 3; j++)
             {
                 //Get vertices: color
                 vtx[j].color = color[i];
 
-                //Get vertices: position
-                vtx[j].position = parser->vertices[face.indices[j]];
-
-                //Transform vertices: perspective division and model to world
-                vtx[j].position = persp_proj * m2w * vtx[j].position;
-
-                //Transform vertices:: perspective division
-                vtx[j].position.x = vtx[j].position.x / vtx[j].position.w;
-                vtx[j].position.y = vtx[j].position.y / vtx[j].position.w;
-                vtx[j].position.z = vtx[j].position.z / vtx[j].position.w;
-                vtx[j].position.w = vtx[j].position.w / vtx[j].position.w;
+                //Get vertices: position, already transformed (homogeneous if it has to be clipped)
+                vtx[j].position = planes ? clip_vertices.Get(face.indices[j]) : screen_vertices[face.indices[j]];
+            }
 
-                //Transform vertices:: view transformation
-                vtx[j].position = viewport * vtx[j].position;
+            //Most faces are inside the guard band, they are drawn directly
+            if (planes == 0)
+            {
+                //Skip the faces that look away from the camera
+                if (cull_back_faces && IsBackFace(vtx))
+                {
+                    culled_faces++;
+                    continue;
+                }
+
+                DrawPolygon(target, vtx, 3);
+                continue;
             }
 
-            //Draw the object
-            if (draw_mode_solid)
-                Rasterizer::DrawTriangleSolid(vtx[0], vtx[1], vtx[2]);
-            else
+            //Same test before the division, the clipped polygon has the same winding
+            if (cull_back_faces && IsBackFaceClip(vtx))
             {
-                //Every line composing the triangle
-                Rasterizer::DrawMidpointLine(vtx[0], vtx[1]);
-                Rasterizer::DrawMidpointLine(vtx[1], vtx[2]);
-                Rasterizer::DrawMidpointLine(vtx[2], vtx[0]);
+                culled_faces++;
+                continue;
             }
+
+            //Clip in homogeneous coordinates, then divide what is left
+            Rasterizer::Vertex polygon[Clipper::MAX_VERTICES];
+            int count = Clipper::ClipTriangle(vtx, polygon, planes, guard_x, guard_y);
+            for (int j = 0; j < count; j++)
+                polygon[j].position = ClipToScreen(polygon[j].position);
+
+            DrawPolygon(target, polygon, count);
         }
 
     }
 
+    //Rasterize the binned triangles in parallel
+    if (draw_mode_solid && raster_mode == RASTER_BINNED)
+        tile_renderer.Flush(target);
+}
+
+
+/**
+* @brief IsBackFace:    check whether a triangle in screen space faces away from the camera
+*
+* @param vtx:           the three vertices of the triangle, after the viewport transformation
+* @return               whether the triangle is a back face (or has no area)
+*/
+bool Tank::IsBackFace(const Rasterizer::Vertex vtx[3]) const
+{
+    //Signed area (doubled) of the triangle
+    //The viewport flips y, so it is negated to get the winding as seen in the scene
+    float area = (vtx[2].position.x - vtx[0].position.x) * (vtx[1].position.y - vtx[0].position.y)
+               - (vtx[1].position.x - vtx[0].position.x) * (vtx[2].position.y - vtx[0].position.y);
+
+    //Counter-clockwise front faces have positive area
+    if (front_face == WINDING_CCW)
+        return area <= 0.f;
+
+    return area >= 0.f;
+}
+
+
+/**
+* @brief IsBackFaceClip: check whether a triangle in clip space faces away from the camera
+*
+* @param vtx:           the three vertices of the triangle, before the perspective division
+* @return               whether the triangle is a back face (or has no area)
+*/
+bool Tank::IsBackFaceClip(const Rasterizer::Vertex vtx[3]) const
+{
+    const Point4& a = vtx[0].position;
+    const Point4& b = vtx[1].position;
+    const Point4& c = vtx[2].position;
+
+    //Determinant of the rows (x, y, w): the signed area after the division times the
+    //three w, so it has the same sign when they are positive, and it still gives the
+    //facing when some vertices are behind the camera
+    float det = a.x * (b.y * c.w - c.y * b.w)
+              - a.y * (b.x * c.w - c.x * b.w)
+              + a.w * (b.x * c.y - c.x * b.y);
+
+    //Counter-clockwise front faces have positive area
+    if (front_face == WINDING_CCW)
+        return det <= 0.f;
+
+    return det >= 0.f;
+}
+
+
+/**
+* @brief ClipToScreen:  perspective division and viewport transformation of a point
+*
+* @param clip:          point in clip space, in front of the camera
+* @return               the point in screen space, with the depth in z
+*/
+Point4 Tank::ClipToScreen(const Point4& clip) const
+{
+    //The viewport only scales and translates, so it is applied per component
+    float inv_w = 1.f / clip.w;
+    return Point4(clip.x * inv_w * viewport.m[0][0] + viewport.m[0][3],
+                  clip.y * inv_w * viewport.m[1][1] + viewport.m[1][3],
+                  clip.z * inv_w);
+}
+
+
+/**
+* @brief DrawPolygon:   draw a convex polygon in screen space with the current mode
+*
+* @param target:        render target
+* @param vtx:           vertices of the polygon, in order
+* @param count:         number of vertices (3 for a triangle, 0 draws nothing)
+*/
+void Tank::DrawPolygon(FrameBuffer& target, const Rasterizer::Vertex* vtx, int count)
+{
+    //Wireframe: only the outline, not the edges of the fan
+    if (!draw_mode_solid)
+    {
+        for (int i = 0; i < count; i++)
+            Rasterizer::DrawMidpointLine(target, vtx[i], vtx[(i + 1) % count]);
+        return;
+    }
+
+    //The polygon is convex, a fan from the first vertex covers it
+    for (int i = 1; i + 1 < count; i++)
+    {
+        if (raster_mode == RASTER_BINNED)
+            tile_renderer.Submit(vtx[0], vtx[i], vtx[i + 1]);
+        else if (raster_mode == RASTER_TILED)
+            Rasterizer::DrawTriangleTiled(target, vtx[0], vtx[i], vtx[i + 1]);
+        else
+            Rasterizer::DrawTriangleSolid(target, vtx[0], vtx[i], vtx[i + 1]);
+    }
 }
 
 
@@ -108,128 +297,99 @@ void Tank::Tank_Update()
 */
 void Tank::Viewport_Transformation()
 {
-    //Viewport transformation
-    viewport.Identity();
-    viewport.m[0][0] =  WIDTH / view_width;
-    viewport.m[0][3] =  WIDTH / 2.f;
-    viewport.m[1][1] = -HEIGHT / view_height;
-    viewport.m[1][3] =  HEIGHT / 2.f;
+    //Viewport transformation, built directly instead of editing an identity
+    viewport = Matrix4(WIDTH / view_width, 0.f,                    0.f, WIDTH / 2.f,
+                       0.f,                -HEIGHT / view_height,  0.f, HEIGHT / 2.f,
+                       0.f,                0.f,                    1.f, 0.f,
+                       0.f,                0.f,                    0.f, 1.f);
 
 }
 
 
 /**
-* @brief Perspective_Projection: calculate the perspective projection matrix
+* @brief Perspective_Projection: set the camera (view and projection) from the input file
 *
 * @param (void)
 */
 void Tank::Perspective_Projection()
 {
-    //Perspective projection
-    persp_proj.Identity();
-    persp_proj.m[3][2] = -1 / parser->focal;
-    persp_proj.m[3][3] = 0;
+    //Camera from the input file, the matrices are built the first time they are used
+    //Depth goes from 0 at the near plane to 1 at the far plane, smaller is closer
+    camera.SetLookAt(parser->position, parser->view, parser->up);
+    camera.SetPerspective(parser->focal, parser->nearPlane, parser->farPlane);
 }
 
 /**
-* @brief ModelToWorld:  calculate the model to world matrix of the object
+* @brief FindObject:    find an object of the scene by name
 *
 * @param obj:           object to find
-* @return               the transform of the found object
+* @return               the index of the found object in the scene
 */
-CS250Parser::Transform* Tank::FindObject(std::string obj)
+int Tank::FindObject(std::string obj)
 {
     for (int i = 0; i < TOTAL_obj; i++)
     {
         //Find the object
         if (!strcmp(obj.c_str(), parser->objects[i].name.c_str()))
-            return &parser->objects[i];
+            return i;
     }
 
     //If it is never found
-    return nullptr;
+    return -1;
 }
 
 
 
 /**
-* @brief ModelToWorld:  calculate the model to world matrix of the object
+* @brief UpdateWorldMatrices: rebuild the matrices of the dirty objects in one pass
+*                             objects are sorted by level, so the parents are always
+*                             done before their children
 *
-* @param obj:           object to calculate the matrix for
-* @param scale:         whether to calculate the scale
-* @return               model to world matrix
-*/
-/**
-* @brief ModelToWorld:  calculate the model to world matrix of the object
-*
-* @param obj:           object to calculate the matrix for
-* @param scale:         whether to calculate the scale
-* @return               model to world matrix
+* @param (void)
 */
-Matrix4 Tank::ModelToWorld(CS250Parser::Transform obj, bool scale)
+void Tank::UpdateWorldMatrices()
 {
-    //Translation
-    Matrix4 Transl;
+    //Each level only depends on the previous one
+    for (size_t level = 0; level + 1 < parser->levelStart.size(); level++)
     {
-        Transl.Identity();
-        Transl.m[0][3] = obj.pos.x;
-        Transl.m[1][3] = obj.pos.y;
-        Transl.m[2][3] = obj.pos.z;
-    }
-
-    //Rotation
-    Matrix4 Rot, RotX, RotY, RotZ;
-    Vector4 angle = obj.rot;
-    {
-        //Rotation x-axis
-        RotX.Identity();
-        RotX.m[1][1] = cos(angle.x);
-        RotX.m[1][2] = -sin(angle.x);
-        RotX.m[2][1] = sin(angle.x);
-        RotX.m[2][2] = cos(angle.x);
-
-        //Rotation y-axis
-        RotY.Identity();
-        RotY.m[0][0] = cos(angle.y);
-        RotY.m[0][2] = sin(angle.y);
-        RotY.m[2][0] = -sin(angle.y);
-        RotY.m[2][2] = cos(angle.y);
-
-        //Rotation z-axis
-        RotZ.Identity();
-        RotZ.m[0][0] = cos(angle.z);
-        RotZ.m[0][1] = -sin(angle.z);
-        RotZ.m[1][0] = sin(angle.z);
-        RotZ.m[1][1] = cos(angle.z);
-
-        //Concatenate rotations
-        Rot = RotZ * RotY * RotX;
-    }
+        for (int i = parser->levelStart[level]; i < parser->levelStart[level + 1]; i++)
+        {
+            CS250Parser::Transform& obj = parser->objects[i];
 
-    //Scale
-    Matrix4 Scale;
-    Scale.Identity();
+            //A parent that changed moves the children too
+            if (obj.parentIndex >= 0 && parser->objects[obj.parentIndex].dirty)
+                obj.dirty = true;
 
-    if (scale)
-    {
-        Scale.m[0][0] = obj.sca.x;
-        Scale.m[1][1] = obj.sca.y;
-        Scale.m[2][2] = obj.sca.z;
+            if (obj.dirty)
+                ModelToWorld(obj);
+        }
     }
 
-    //Complete concatenation for the m2w matrix
-    Matrix4 m2w = Transl * Rot * Scale;
+    //Every matrix is up to date
+    for (int i = 0; i < TOTAL_obj; i++)
+        parser->objects[i].dirty = false;
+}
 
-    //If there is a parent, multiply its the M2W matrix
-    if (strcmp(obj.parent.c_str(), "None"))
-    {
-        CS250Parser::Transform* parent = FindObject(obj.parent);
 
-        if (parent)
-            m2w = ModelToWorld(*parent, false) * m2w;
-    }
+/**
+* @brief ModelToWorld:  rebuild the cached matrices of the object
+*                       the world matrix of the parent (without its scale) must be
+*                       up to date, it is the frame of the object
+*
+* @param obj:           object to calculate the matrices for
+*/
+void Tank::ModelToWorld(CS250Parser::Transform& obj)
+{
+    //Local transformation T * R in one go, without the scale (children do not inherit it)
+    obj.local = Affine4::Compose(obj.pos, obj.orientation, Vector4(1.f, 1.f, 1.f));
+    obj.world = obj.local;
+
+    //If there is a parent, multiply its world matrix
+    if (obj.parentIndex >= 0)
+        obj.world = parser->objects[obj.parentIndex].world * obj.local;
 
-    return m2w;
+    //Complete concatenation for the m2w matrix, the scale only multiplies the columns
+    obj.m2w = obj.world.Scaled(obj.sca);
 }
 
 
@@ -241,46 +401,71 @@ Matrix4 Tank::ModelToWorld(CS250Parser::Transform obj, bool scale)
 */
 bool Tank::GetInput()
 {
+    CS250Parser::Transform* body   = &parser->objects[obj_body];
+    CS250Parser::Transform* turret = &parser->objects[obj_turret];
+    CS250Parser::Transform* joint  = &parser->objects[obj_joint];
+
     //Tank body rotation
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::A))
-        FindObject("body")->rot.y += 0.05f;
+    {
+        RotateObject(*body, Vector4(0.f, 1.f, 0.f), 0.05f);
+    }
 
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::D))
-        FindObject("body")->rot.y -= 0.05f;
+    {
+        RotateObject(*body, Vector4(0.f, 1.f, 0.f), -0.05f);
+    }
 
 
     //Turret rotation
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::Q))
-        FindObject("turret")->rot.y += 0.05f;
+    {
+        RotateObject(*turret, Vector4(0.f, 1.f, 0.f), 0.05f);
+    }
 
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::E))
-        FindObject("turret")->rot.y -= 0.05f;
+    {
+        RotateObject(*turret, Vector4(0.f, 1.f, 0.f), -0.05f);
+    }
 
 
     //Gun rotation
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::F))
-        FindObject("joint")->rot.x += 0.05f;
+    {
+        RotateObject(*joint, Vector4(1.f, 0.f, 0.f), 0.05f);
+    }
 
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::R))
-        FindObject("joint")->rot.x -= 0.05f;
+    {
+        RotateObject(*joint, Vector4(1.f, 0.f, 0.f), -0.05f);
+    }
 
 
 
     //Move tank forward
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::Space))
     {
-        //Move body
-        FindObject("body")->pos.z += 1.f * cos(FindObject("body")->rot.y);
-        FindObject("body")->pos.x += 1.f * sin(FindObject("body")->rot.y);
+        //Move body along its own z axis, projected on the ground. It is (sin y, cos y)
+        //only while the body has no x or z rotation, and it is shorter when the body is tilted
+        Vector4 forward = body->orientation.Rotate(Vector4(0.f, 0.f, 1.f));
+        body->pos.z += 1.f * forward.z;
+        body->pos.x += 1.f * forward.x;
+        body->dirty = true;
 
         //Turn wheels
-        FindObject("wheel1")->rot.x += 0.1f;
-        FindObject("wheel2")->rot.x += 0.1f;
-        FindObject("wheel3")->rot.x += 0.1f;
-        FindObject("wheel4")->rot.x += 0.1f;
+        for (int wheel : obj_wheels)
+            RotateObject(parser->objects[wheel], Vector4(1.f, 0.f, 0.f), 0.1f);
 
     }
 
+    //Check scanline/tiled/binned rasterizer
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Num3))
+        raster_mode = RASTER_SCANLINE;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Num4))
+        raster_mode = RASTER_TILED;
+    if (sf::Keyboard::isKeyPressed(sf::Keyboard::Num5))
+        raster_mode = RASTER_BINNED;
+
     //Check solid/wireframe mode
     if (sf::Keyboard::isKeyPressed(sf::Keyboard::Num1))
         return false;
@@ -290,3 +475,22 @@ bool Tank::GetInput()
 
     return draw_mode_solid;
 }
+
+
+/**
+* @brief RotateObject:  rotate an object around one of its own axes, the orientation
+*                       is renormalized so it does not drift over long sessions.
+*                       The step is applied after the current orientation (local axis),
+*                       which is the same as adding to the Euler angle only while the
+*                       object is not rotated around the other two axes
+*
+* @param obj:           object to rotate
+* @param axis:          axis of the object to rotate around, length 1
+* @param angle:         angle in radians
+*/
+void Tank::RotateObject(CS250Parser::Transform& obj, const Vector4& axis, float angle)
+{
+    obj.orientation *= Quaternion::FromAxisAngle(axis, angle);
+    obj.orientation.Normalize();
+    obj.dirty = true;
+}
@@ -23,7 +23,10 @@ Hours spent on this assignment: ~20
 
 #include "FrameBuffer.h"		//Frame buffer class
 #include "Rasterizer.h"			//Rasterizer class
+#include "Clipper.h"			//Clipping in homogeneous coordinates
+#include "TileRenderer.h"		//Multithreaded binned rasterizer
 #include "CS250Parser.h"		//Parser class
+#include "Camera.h"			//Look-at view and perspective projection
 #include "Math/Matrix4.h"		//Matrix 4*4 class
 #include "Math/Point4.h"		//Point of size 4 class
 
@@ -37,15 +40,22 @@ public:
 	//------------
 
 	void Tank_Initialize();							//Initialize tank object
-	void Tank_Update();								//Renders the current state of the tank
+	void Tank_Update(FrameBuffer& target, bool input = true);	//Renders the current state of the tank into target
 
 	void Viewport_Transformation();					//Calculate the viewport transformation matrix
-	void Perspective_Projection();					//Calculate the perspective projection matrix
+	void Perspective_Projection();					//Set the camera from the input file
 
-	Matrix4 ModelToWorld(CS250Parser::Transform obj, bool scale);
-	CS250Parser::Transform* FindObject(std::string obj);
+	void UpdateWorldMatrices();							//Rebuild the matrices of the dirty objects
+	void ModelToWorld(CS250Parser::Transform& obj);		//Rebuild the cached matrices of one object
+	int FindObject(std::string obj);
 
 	bool GetInput();
+	void RotateObject(CS250Parser::Transform& obj, const Vector4& axis, float angle);	//Rotate around one of its own axes
+
+	bool IsBackFace(const Rasterizer::Vertex vtx[3]) const;	//Check the winding of a projected triangle
+	bool IsBackFaceClip(const Rasterizer::Vertex vtx[3]) const;	//Same check in clip space, before the division
+	unsigned GetCulledFaces() const { return culled_faces; }	//Back faces skipped in the last update
+	unsigned GetRejectedFaces() const { return rejected_faces; }	//Faces outside of the frustum in the last update
 
 
 	//------------
@@ -55,6 +65,16 @@ public:
 	const int WIDTH = 1280;			//Window size
 	const int HEIGHT = 960;
 
+	enum Winding { WINDING_CCW, WINDING_CW };
+
+	bool cull_back_faces = true;			//Back-face culling
+	Winding front_face = WINDING_CCW;		//Winding of the front faces in the input file
+
+	enum RasterMode { RASTER_SCANLINE, RASTER_TILED, RASTER_BINNED };
+
+	RasterMode raster_mode = RASTER_SCANLINE;	//Rasterizer used for solid triangles
+	unsigned raster_threads = 0;				//Threads of the binned rasterizer (0 for every core)
+
 private:
 
 	int TOTAL_obj;
@@ -65,14 +85,33 @@ private:
 
 	CS250Parser* parser;			//Parser with input data
 
-	Matrix4 viewport;				//Matrices that only need to be computed once
-	Matrix4 persp_proj;
+	int obj_body;					//Index of the objects moved by the input
+	int obj_turret;
+	int obj_joint;
+	int obj_wheels[4];
+
+	Point4 ClipToScreen(const Point4& clip) const;				//Perspective division and viewport
+	void DrawPolygon(FrameBuffer& target, const Rasterizer::Vertex* vtx, int count);	//Draw a convex polygon in screen space
+
+	TileRenderer tile_renderer;		//Binned rasterizer, used in RASTER_BINNED mode
+
+	Matrix4 viewport;				//Matrix that only needs to be computed once
+	Camera camera;					//View and projection, rebuilt only when the camera changes
 	
 	Matrix4 m2w_body;				//Model to world transformation of the body
 
 	Point4 color[12];				//Color of each triangle
 
+	Point4SoA model_vertices;				//Vertices of the mesh, in model space
+	Point4SoA clip_vertices;				//Vertices of the current object in clip space, before the division
+	std::vector<Point4> screen_vertices;	//Vertices of the current object in screen space
+	std::vector<unsigned> screen_codes;		//Frustum planes each vertex is outside of
+	std::vector<unsigned> guard_codes;		//Same, with the guard band instead of the screen edges
+
 	bool draw_mode_solid = true;	//Drawing mode
 
+	unsigned culled_faces = 0;		//Number of faces culled in the last update
+	unsigned rejected_faces = 0;	//Number of faces outside of the frustum in the last update
+
 	//enum obj { body, turret, joint, gun, wheel1, wheel2, wheel3, wheel4, TOTAL };
 };
\ No newline at end of file
@@ -0,0 +1,172 @@
+#include "TileRenderer.h"
+#include "FrameBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+
+
+TileRenderer::~TileRenderer()
+{
+    Free();
+}
+
+/**
+* @brief Init:      create the bins and start the worker threads
+*
+* @param w, h:      size of the frame buffer
+* @param threads:   number of threads, including the calling one (0 to use every core)
+*/
+void TileRenderer::Init(int w, int h, unsigned threads)
+{
+    Free();
+
+    width  = w;
+    height = h;
+    binsX  = (width + BIN_SIZE - 1) / BIN_SIZE;
+    binsY  = (height + BIN_SIZE - 1) / BIN_SIZE;
+    bins.resize(binsX * binsY);
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    //The calling thread also rasterizes, so it is not counted as a worker.
+    //The workers start at the current generation, it is not reset by Free
+    quit = false;
+    for (unsigned i = 1; i < threads; i++)
+        workers.emplace_back(&TileRenderer::WorkerLoop, this, generation);
+}
+
+/**
+* @brief Free:      stop the worker threads
+*
+* @param (void)
+*/
+void TileRenderer::Free()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_all();
+
+    for (std::thread & worker : workers)
+        worker.join();
+
+    workers.clear();
+    bins.clear();
+    triangles.clear();
+}
+
+/**
+* @brief Submit:    add a triangle (in screen space) to every tile its bounding box touches
+*
+* @param v0, v1, v2: vertices of the triangle
+*/
+void TileRenderer::Submit(const Rasterizer::Vertex & v0, const Rasterizer::Vertex & v1, const Rasterizer::Vertex & v2)
+{
+    float xMin = std::min({v0.position.x, v1.position.x, v2.position.x});
+    float xMax = std::max({v0.position.x, v1.position.x, v2.position.x});
+    float yMin = std::min({v0.position.y, v1.position.y, v2.position.y});
+    float yMax = std::max({v0.position.y, v1.position.y, v2.position.y});
+
+    //Completely off screen
+    if (xMax < 0.f || yMax < 0.f || xMin >= width || yMin >= height)
+        return;
+
+    int bx0 = std::max(0, static_cast<int>(xMin) / BIN_SIZE);
+    int by0 = std::max(0, static_cast<int>(yMin) / BIN_SIZE);
+    int bx1 = std::min(binsX - 1, static_cast<int>(std::ceil(xMax)) / BIN_SIZE);
+    int by1 = std::min(binsY - 1, static_cast<int>(std::ceil(yMax)) / BIN_SIZE);
+
+    int index = static_cast<int>(triangles.size() / 3);
+    triangles.push_back(v0);
+    triangles.push_back(v1);
+    triangles.push_back(v2);
+
+    for (int by = by0; by <= by1; by++)
+        for (int bx = bx0; bx <= bx1; bx++)
+            bins[by * binsX + bx].push_back(index);
+}
+
+/**
+* @brief Flush:     rasterize every submitted triangle and wait until the frame is done
+*
+* @param target:    render target, the same size given to Init
+*/
+void TileRenderer::Flush(FrameBuffer & target)
+{
+    this->target = &target;
+    nextBin = 0;
+    busy    = static_cast<int>(workers.size());
+
+    //Wake up the workers and help them
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation++;
+    }
+    wake.notify_all();
+
+    RasterizeBins();
+
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return busy == 0; });
+    }
+
+    //Ready for the next frame
+    triangles.clear();
+    for (std::vector<int> & bin : bins)
+        bin.clear();
+}
+
+/**
+* @brief WorkerLoop: wait for a frame, rasterize bins until there are none left
+*
+* @param seen:      generation when the worker was started, only newer frames are drawn
+*/
+void TileRenderer::WorkerLoop(unsigned seen)
+{
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this, seen] { return quit || generation != seen; });
+
+            if (quit)
+                return;
+
+            seen = generation;
+        }
+
+        RasterizeBins();
+
+        //The last worker to finish wakes up Flush
+        if (--busy == 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_one();
+        }
+    }
+}
+
+/**
+* @brief RasterizeBins: take bins one by one and draw their triangles clipped to the tile
+*
+* @param (void)
+*/
+void TileRenderer::RasterizeBins()
+{
+    int count = binsX * binsY;
+
+    for (int bin = nextBin++; bin < count; bin = nextBin++)
+    {
+        int x0 = (bin % binsX) * BIN_SIZE;
+        int y0 = (bin / binsX) * BIN_SIZE;
+
+        for (int tri : bins[bin])
+        {
+            const Rasterizer::Vertex * vtx = &triangles[3 * tri];
+            Rasterizer::DrawTriangleTiled(*target, vtx[0], vtx[1], vtx[2], x0, y0, x0 + BIN_SIZE, y0 + BIN_SIZE);
+        }
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Rasterizer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Bins the triangles of a frame into screen tiles and rasterizes the tiles in parallel.
+// Every tile is drawn by a single thread, so the threads write disjoint parts of the
+// render target and need no locks while rasterizing.
+class TileRenderer
+{
+  public:
+    static const int BIN_SIZE = 64;     //Size of a tile in pixels, multiple of the rasterizer tile
+
+    ~TileRenderer();
+
+    void Init(int w, int h, unsigned threads = 0);
+    void Free();
+
+    void Submit(const Rasterizer::Vertex & v0, const Rasterizer::Vertex & v1, const Rasterizer::Vertex & v2);
+    void Flush(FrameBuffer & target);
+
+    unsigned GetThreadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+  private:
+    void WorkerLoop(unsigned seen);
+    void RasterizeBins();
+
+    int width   = 0;
+    int height  = 0;
+    int binsX   = 0;
+    int binsY   = 0;
+
+    std::vector<Rasterizer::Vertex> triangles;    //3 vertices per submitted triangle
+    std::vector<std::vector<int>>   bins;         //Triangles overlapping each tile, in submission order
+    FrameBuffer *                   target = nullptr;   //Where the current Flush draws
+
+    std::vector<std::thread> workers;
+    std::mutex               mutex;               //Only guards waking up and finishing a frame
+    std::condition_variable  wake;
+    std::condition_variable  done;
+    unsigned                 generation = 0;
+    bool                     quit       = false;
+    std::atomic<int>         nextBin{0};
+    std::atomic<int>         busy{0};
+};
@@ -11,7 +11,7 @@
 
 This file contains the implementation of the following functions for the
 Tank assignment.
-Functions include:	main
+Functions include:	main, RunHeadless
 
 Hours spent on this assignment: ~20
 
@@ -19,53 +19,146 @@ Hours spent on this assignment: ~20
 /****************************************************************************************/
 
 #include "TankFunctions.h"
+#include "SwapChain.h"
 
-int main()
+#include <cstdlib>      //atoi
+#include <cstring>      //strcmp
+
+
+/**
+* @brief RunHeadless:   render a number of frames into the frame buffer without a window
+*
+* @param tank:          tank to render
+* @param frame:         render target
+* @param frames:        number of frames to render
+* @param dumpFrame:     frame to save to a file (-1 for none)
+* @param dumpFile:      name of the PPM file to save the frame to
+*/
+void RunHeadless(Tank& tank, FrameBuffer& frame, int frames, int dumpFrame, const char* dumpFile)
 {
+    sf::Clock clock;
+    unsigned  culled = 0;
+    unsigned  rejected = 0;
+
+    for (int i = 0; i < frames; i++)
+    {
+        frame.Clear(sf::Color::White.r, sf::Color::White.g, sf::Color::White.b);
+
+        // Calculate tank position, there is no keyboard to read from
+        tank.Tank_Update(frame, false);
+        culled += tank.GetCulledFaces();
+        rejected += tank.GetRejectedFaces();
+
+        // Save the requested frame
+        if (i == dumpFrame && !frame.SaveToPPM(dumpFile))
+            printf("Could not write frame %d to %s\n", i, dumpFile);
+    }
+
+    float seconds = clock.getElapsedTime().asSeconds();
+    printf("Span writer: %s, %s layout\n", FrameBuffer::GetSpanWriterName(), frame.GetLayout() == FrameBuffer::LAYOUT_TILED ? "tiled" : "linear");
+    printf("%d frames in %.3f s (%.1f fps)\n", frames, seconds, seconds > 0.f ? frames / seconds : 0.f);
+    printf("%.1f back faces culled per frame\n", static_cast<float>(culled) / frames);
+    printf("%.1f faces outside of the frustum per frame\n", static_cast<float>(rejected) / frames);
+}
+
+/**
+* @brief main:  open the window and render the tank, or benchmark it offscreen
+*
+*   Usage:  tank [--selftest] [--headless <frames>] [--dump <frame> <file.ppm>] [--tiled | --binned [threads]] [--swizzle] [--buffers <count>]
+*/
+int main(int argc, char* argv[])
+{
+    //Read command line options
+    int                 frames    = 0;
+    int                 dumpFrame = -1;
+    const char*         dumpFile  = nullptr;
+    int                 threads   = 0;
+    Tank::RasterMode    mode      = Tank::RASTER_SCANLINE;
+    FrameBuffer::Layout layout    = FrameBuffer::LAYOUT_LINEAR;
+    int                 buffers   = 2;
+    bool                selfTest  = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--headless") && i + 1 < argc)
+            frames = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--selftest"))
+            selfTest = true;
+        else if (!strcmp(argv[i], "--dump") && i + 2 < argc)
+        {
+            dumpFrame = atoi(argv[++i]);
+            dumpFile  = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--tiled"))
+            mode = Tank::RASTER_TILED;
+        else if (!strcmp(argv[i], "--binned"))
+        {
+            mode = Tank::RASTER_BINNED;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+                threads = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--swizzle"))
+            layout = FrameBuffer::LAYOUT_TILED;
+        else if (!strcmp(argv[i], "--buffers") && i + 1 < argc)
+            buffers = atoi(argv[++i]);
+    }
+
+    // Check the SIMD math against the constexpr results, then quit
+    if (selfTest)
+    {
+        bool passed = Matrix4::SelfTest();
+        printf("Matrix4 self-test %s\n", passed ? "passed" : "failed");
+        return passed ? 0 : 1;
+    }
+
     //Create a tank
     Tank tank;
+    tank.raster_mode    = mode;
+    tank.raster_threads = threads;
     tank.Tank_Initialize();
 
-    sf::RenderWindow window(sf::VideoMode(tank.WIDTH, tank.HEIGHT), "SFML works!");
-
-    FrameBuffer::Init(tank.WIDTH, tank.HEIGHT);
+    // Render offscreen, without creating a window
+    if (frames > 0)
+    {
+        FrameBuffer frame(tank.WIDTH, tank.HEIGHT, layout);
+        RunHeadless(tank, frame, frames, dumpFile ? dumpFrame : -1, dumpFile);
+        return 0;
+    }
 
-    // Generate image and texture to display
-    sf::Image   image;
-    sf::Texture texture;
-    sf::Sprite  sprite;
-    texture.create(tank.WIDTH, tank.HEIGHT);
-    image.create(tank.WIDTH, tank.HEIGHT, sf::Color::Black);
+    sf::RenderWindow window(sf::VideoMode(tank.WIDTH, tank.HEIGHT), "SFML works!");
 
+    // A presentation thread uploads and displays each frame while the next one is drawn.
+    // The window still belongs to this thread for the events
+    SwapChain swapChain;
+    swapChain.Init(window, layout, buffers);
 
-    while (window.isOpen())
+    bool running = true;
+    while (running)
     {
-        FrameBuffer::Clear(sf::Color::White.r, sf::Color::White.g, sf::Color::White.b);
+        FrameBuffer& frame = swapChain.Acquire();
+        frame.Clear(sf::Color::White.r, sf::Color::White.g, sf::Color::White.b);
 
         // Handle input
         sf::Event event;
         while (window.pollEvent(event))
         {
             if (event.type == sf::Event::Closed)
-                window.close();
+                running = false;
         }
 
         if (sf::Keyboard::isKeyPressed(sf::Keyboard::Escape))
-            window.close();
+            running = false;
 
         // Calculate tank position
-        tank.Tank_Update();
+        tank.Tank_Update(frame);
 
         // Show image on screen
-        FrameBuffer::ConvertFrameBufferToSFMLImage(image);
-
-        texture.update(image);
-        sprite.setTexture(texture);
-        window.draw(sprite);
-        window.display();
+        swapChain.Present();
     }
-    
-    FrameBuffer::Free();
+
+    // Stop presenting before the window goes away
+    swapChain.Free();
+    window.close();
 
     return 2;
 }
@@ -9,14 +9,14 @@ int main2()
 
     sf::RenderWindow window(sf::VideoMode(WIDTH, HEIGHT), "SFML works!");
 
-    FrameBuffer::Init(WIDTH, HEIGHT);
+    // Only color is written, no depth plane is needed
+    FrameBuffer frame(WIDTH, HEIGHT, FrameBuffer::LAYOUT_LINEAR, false);
 
-    // Generate image and texture to display
-    sf::Image   image;
+    // Generate the texture to display, the frame buffer is uploaded to it directly
     sf::Texture texture;
     sf::Sprite  sprite;
     texture.create(WIDTH, HEIGHT);
-    image.create(WIDTH, HEIGHT, sf::Color::Black);
+    sprite.setTexture(texture);
 
     // Init the clock
     sf::Clock clock;
@@ -44,30 +44,26 @@ int main2()
                 if (time % 2 == 0)
                 {
                     if (y % 50 < 25 && x % 50 < 25)
-                        FrameBuffer::SetPixel(x, y, 255, 0, 0);
+                        frame.SetPixel(x, y, 255, 0, 0);
                     else
-                        FrameBuffer::SetPixel(x, y, 0, 255, 0);
+                        frame.SetPixel(x, y, 0, 255, 0);
                 }
                 else
                 {
                     if (y % 50 < 25 && x % 50 < 25)
-                        FrameBuffer::SetPixel(x, y, 0, 255, 0);
+                        frame.SetPixel(x, y, 0, 255, 0);
                     else
-                        FrameBuffer::SetPixel(x, y, 255, 0, 0);
+                        frame.SetPixel(x, y, 255, 0, 0);
                 }
             }
         }
 
         // Show image on screen
-        FrameBuffer::ConvertFrameBufferToSFMLImage(image);
+        frame.UpdateTexture(texture);
 
-        texture.update(image);
-        sprite.setTexture(texture);
         window.draw(sprite);
         window.display();
     }
-    
-    FrameBuffer::Free();
 
     return 0;
 }
\ No newline at end of file